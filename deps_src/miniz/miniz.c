@@ -6759,9 +6759,12 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     if ((int)level_and_flags < 0)
         level_and_flags = MZ_DEFAULT_LEVEL;
     level = level_and_flags & 0xF;
+    /* Level 0 stores the data without compression. */
+    if (level == 0)
+        pContext->method = 0;
 
     /* Sanity checks */
-    if ((!pZip) || (!pZip->m_pState) || (pZip->m_zip_mode != MZ_ZIP_MODE_WRITING) || (!pArchive_name) || ((comment_size) && (!pComment)) || (level == 0) || (level > MZ_UBER_COMPRESSION) || (max_size < 4))
+    if ((!pZip) || (!pZip->m_pState) || (pZip->m_zip_mode != MZ_ZIP_MODE_WRITING) || (!pArchive_name) || ((comment_size) && (!pComment)) || (level > MZ_UBER_COMPRESSION) || (max_size < 4))
         return mz_zip_set_error(pZip, MZ_ZIP_INVALID_PARAMETER);
 
     pState = pZip->m_pState;
@@ -6878,7 +6881,14 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
     }
 
     assert(max_size);
-    assert(level);
+
+    pContext->add_state.m_pZip = pZip;
+    pContext->add_state.m_cur_archive_file_ofs = pContext->cur_archive_file_ofs;
+    pContext->add_state.m_comp_size = 0;
+
+    /* Stored data is written directly by mz_zip_writer_add_staged_data(). */
+    if (level == 0)
+        return MZ_TRUE;
 
     pContext->pCompressor = (tdefl_compressor*)pZip->m_pAlloc(pZip->m_pAlloc_opaque, 1, sizeof(tdefl_compressor));
     if (!pContext->pCompressor)
@@ -6886,10 +6896,6 @@ mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged
         return mz_zip_set_error(pZip, MZ_ZIP_ALLOC_FAILED);
     }
 
-    pContext->add_state.m_pZip = pZip;
-    pContext->add_state.m_cur_archive_file_ofs = pContext->cur_archive_file_ofs;
-    pContext->add_state.m_comp_size = 0;
-
     if (tdefl_init(pContext->pCompressor, mz_zip_writer_add_put_buf_callback, &pContext->add_state, tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY)) != TDEFL_STATUS_OKAY)
     {
         pZip->m_pFree(pZip->m_pAlloc_opaque, pContext->pCompressor);
@@ -6914,6 +6920,17 @@ mz_bool mz_zip_writer_add_staged_data(mz_zip_writer_staged_context *pContext, co
     pContext->file_ofs += n;
     pContext->uncomp_crc32 = (mz_uint32)mz_crc32(pContext->uncomp_crc32, (const mz_uint8 *)pRead_buf, n);
 
+    if (pContext->method == 0)
+    {
+        if (n == 0 || pContext->pZip->m_pWrite(pContext->pZip->m_pIO_opaque, pContext->add_state.m_cur_archive_file_ofs, pRead_buf, n) == n)
+        {
+            pContext->add_state.m_cur_archive_file_ofs += n;
+            pContext->add_state.m_comp_size += n;
+            return MZ_TRUE;
+        }
+        return mz_zip_set_error(pContext->pZip, MZ_ZIP_FILE_WRITE_FAILED);
+    }
+
     if (pContext->pZip->m_pNeeds_keepalive != NULL && pContext->pZip->m_pNeeds_keepalive(pContext->pZip->m_pIO_opaque))
         flush = TDEFL_FULL_FLUSH;
 
@@ -6933,7 +6950,7 @@ mz_bool mz_zip_writer_add_staged_finish(mz_zip_writer_staged_context *pContext)
 {
     if (! mz_zip_writer_add_staged_data(pContext, NULL, 0) ||
         // Either never opened, or already finished.
-        ! pContext->pCompressor)
+        (pContext->method == MZ_DEFLATED && ! pContext->pCompressor))
         return MZ_FALSE;
 
     pContext->pZip->m_pFree(pContext->pZip->m_pAlloc_opaque, pContext->pCompressor);
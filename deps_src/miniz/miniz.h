@@ -1357,7 +1357,7 @@ typedef struct mz_zip_writer_staged_context
     mz_uint      user_extra_data_central_len;
 } mz_zip_writer_staged_context;
 
-/* Adds a file to an archive piecewise. Minimum size of the raw data is 4 bytes. */
+/* Adds a file to an archive piecewise. Minimum size of the raw data is 4 bytes. Level 0 stores the data without compression. */
 /* Don't call mz_zip_writer_add_staged_finish() if mz_zip_writer_add_staged_open() or mz_zip_writer_add_staged_data() fails. */
 mz_bool mz_zip_writer_add_staged_open(mz_zip_archive* pZip, mz_zip_writer_staged_context* pContext, const char* pArchive_name, 
     mz_uint64 max_size, const MZ_TIME_T* pFile_time, const void* pComment, mz_uint16 comment_size, mz_uint level_and_flags,
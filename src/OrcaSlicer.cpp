@@ -17,11 +17,18 @@
     #endif /* SLIC3R_GUI */
 #endif /* WIN32 */
 
+#include <chrono>
 #include <cstdio>
+#include <ctime>
 #include <string>
 #include <cstring>
 #include <iostream>
 #include <math.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #if defined(__linux__) || defined(__LINUX__)
 #include <condition_variable>
@@ -34,6 +41,7 @@ using namespace nlohmann;
 #endif
 
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/nowide/args.hpp>
 #include <boost/nowide/cstdlib.hpp>
@@ -351,6 +359,14 @@ typedef struct _cli_callback_mgr {
             close(m_pipe_fd);
             m_pipe_fd = -1;
         }
+        // Reset the state, the batch server starts the manager again for the next job.
+        lck.lock();
+        m_started        = false;
+        m_exit           = false;
+        m_data_ready     = false;
+        m_progress       = 0;
+        m_total_progress = 0;
+        lck.unlock();
         BOOST_LOG_TRIVIAL(info) << "cli_callback_mgr_t::stop successfully.";
     }
 }cli_callback_mgr_t;
@@ -405,6 +421,52 @@ static PrinterTechnology get_printer_technology(const DynamicConfig &config)
     return(ret);}
 #endif
 
+// Set while running the jobs of the batch server, see CLI::run_batch_server().
+static bool s_batch_server_mode = false;
+
+// Settings file parsed by a previous job of the batch server.
+struct CachedSettingsFile
+{
+    // Content of the file when it was parsed. The modification time is not precise enough to detect a profile rewritten
+    // within the same second, the content of a profile is small compared to the cost of parsing it.
+    std::string                         content;
+    DynamicPrintConfig                  config;
+    std::map<std::string, std::string>  key_values;
+    std::string                         reason;
+    ConfigSubstitutions                 substitutions;
+};
+// Most of the jobs of the batch server load the same system profiles, keep them parsed between the jobs.
+static std::map<std::string, CachedSettingsFile> s_settings_files_cache;
+
+static ConfigSubstitutions load_settings_from_json(DynamicPrintConfig &config, const std::string &file, ForwardCompatibilitySubstitutionRule rule,
+    std::map<std::string, std::string> &key_values, std::string &reason)
+{
+    if (! s_batch_server_mode || ! config.empty())
+        return config.load_from_json(file, rule, key_values, reason);
+
+    std::string content;
+    {
+        boost::nowide::ifstream ifs(file, std::ios::binary);
+        if (ifs)
+            content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        if (! ifs || ifs.bad())
+            // Missing or unreadable file, let load_from_json() report the error as it does outside of the batch server.
+            return config.load_from_json(file, rule, key_values, reason);
+    }
+    auto it = s_settings_files_cache.find(file);
+    if (it == s_settings_files_cache.end() || it->second.content != content) {
+        CachedSettingsFile cached;
+        cached.content       = std::move(content);
+        cached.substitutions = cached.config.load_from_json(file, rule, cached.key_values, cached.reason);
+        it = s_settings_files_cache.insert_or_assign(file, std::move(cached)).first;
+    } else
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": reusing settings file " << file << " loaded by a previous job";
+    config     = it->second.config;
+    key_values = it->second.key_values;
+    reason     = it->second.reason;
+    return it->second.substitutions;
+}
+
 void record_exit_reson(std::string outputdir, int code, int plate_id, std::string error_message, sliced_info_t& sliced_info, std::map<std::string, std::string> key_values = std::map<std::string, std::string>())
 {
 #if defined(__linux__) || defined(__LINUX__)
@@ -1263,7 +1325,19 @@ int CLI::run(int argc, char **argv)
     if (downward_check_option)
         downward_check = downward_check_option->value;
 
+    if (m_config.opt_bool("batch_server")) {
+        if (s_batch_server_mode) {
+            boost::nowide::cerr << "batch_server can not be used by a job of the batch server" << std::endl;
+            return CLI_INVALID_PARAMS;
+        }
+        return this->run_batch_server(argv[0]);
+    }
+
     bool start_gui = m_actions.empty() && !downward_check;
+    if (start_gui && s_batch_server_mode) {
+        boost::nowide::cerr << "no action specified by the job of the batch server" << std::endl;
+        return CLI_INVALID_PARAMS;
+    }
     if (start_gui) {
         BOOST_LOG_TRIVIAL(info) << "no action, start gui directly" << std::endl;
 #ifdef SLIC3R_GUI
@@ -1442,6 +1516,15 @@ int CLI::run(int argc, char **argv)
     if (custom_gcode_option)
         custom_gcode_file = custom_gcode_option->value;
 
+    std::string slice_cache_dir;
+    ConfigOptionString* slice_cache_dir_option = m_config.option<ConfigOptionString>("slice_cache_dir");
+    if (slice_cache_dir_option)
+        slice_cache_dir = slice_cache_dir_option->value;
+    ConfigOptionBool* export_slicing_stats_option = m_config.option<ConfigOptionBool>("export_slicing_stats");
+    bool export_slicing_stats = export_slicing_stats_option && export_slicing_stats_option->value;
+    ConfigOptionInt* tree_support_avoidance_memory_budget_option = m_config.option<ConfigOptionInt>("tree_support_avoidance_memory_budget");
+    size_t tree_support_avoidance_memory_budget = tree_support_avoidance_memory_budget_option ? size_t(std::max(0, tree_support_avoidance_memory_budget_option->value)) << 20 : 0;
+
     std::string load_assemble_list;
     std::vector<assemble_plate_info_t> assemble_plate_info_list;
     ConfigOptionString* load_assemble_list_option = m_config.option<ConfigOptionString>("load_assemble_list");
@@ -1857,7 +1940,7 @@ int CLI::run(int argc, char **argv)
             std::map<std::string, std::string> key_values;
             std::string reason;
 
-            config_substitutions = config.load_from_json(file, config_substitution_rule, key_values, reason);
+            config_substitutions = load_settings_from_json(config, file, config_substitution_rule, key_values, reason);
             if (!reason.empty()) {
                 BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<<  ":Can not load config from file "<<file<<"\n";
                 return CLI_CONFIG_FILE_ERROR;
@@ -5949,6 +6032,13 @@ int CLI::run(int argc, char **argv)
 
                         StringObjectException warning;
                         print_fff->set_check_multi_filaments_compatibility(!allow_mix_temp);
+                        print_fff->set_step_cache_dir(slice_cache_dir);
+                        print_fff->profiler().set_enabled(export_slicing_stats);
+                        print_fff->set_tree_support_avoidance_memory_budget(tree_support_avoidance_memory_budget);
+                        // The layers are not needed after the G-code export unless the slicing data is exported.
+                        print_fff->set_release_extrusions_on_export(!export_slicedata);
+                        // No later apply() reuses the slices of the volumes.
+                        print_fff->set_retain_volume_slices(false);
                         auto err = print->validate(&warning);
                         if (!err.string.empty()) {
                             if ((STRING_EXCEPT_LAYER_HEIGHT_EXCEEDS_LIMIT == err.type) && no_check) {
@@ -6146,8 +6236,9 @@ int CLI::run(int argc, char **argv)
                                 if (export_slicedata) {
                                     BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ":will export Slicing data to " << export_slice_data_dir;
                                     std::string plate_dir = export_slice_data_dir+"/"+std::to_string(index+1);
+                                    // Readable JSON when debugging, compact binary data otherwise.
                                     bool with_space = (get_logging_level() >= 4)?true:false;
-                                    int ret = print->export_cached_data(plate_dir, with_space);
+                                    int ret = print->export_cached_data(plate_dir, with_space, !with_space);
                                     if (ret) {
                                         BOOST_LOG_TRIVIAL(error) << "plate "<< index+1<< ": export Slicing data error, ret=" << ret;
                                         export_slicedata_error = true;
@@ -6157,6 +6248,14 @@ int CLI::run(int argc, char **argv)
                                         flush_and_exit(ret);
                                     }
                                 }
+                                if (export_slicing_stats) {
+                                    std::string stats_file = (outfile_dir.empty() ? std::string() : outfile_dir + "/") + "slicing_stats_plate_" + std::to_string(index + 1) + ".json";
+                                    boost::nowide::ofstream c;
+                                    c.open(stats_file, std::ios::out | std::ios::trunc);
+                                    c << print_fff->profiler().to_json() << std::endl;
+                                    c.close();
+                                    BOOST_LOG_TRIVIAL(info) << "plate "<< index+1<< ": slicing statistics exported to " << stats_file;
+                                }
                                 end_time = (long long)Slic3r::Utils::get_current_time_utc();
                                 sliced_plate_info.sliced_time = end_time - start_time;
                                 sliced_plate_info.sliced_time_with_cache = time_using_cache;
@@ -6998,6 +7097,98 @@ int CLI::run(int argc, char **argv)
     return 0;
 }
 
+int CLI::run_batch_server(const std::string &program_name)
+{
+    const ConfigOptionInt* opt_loglevel = m_config.opt<ConfigOptionInt>("debug");
+    set_logging_level(opt_loglevel ? opt_loglevel->value : 2);
+    BOOST_LOG_TRIVIAL(warning) << boost::format("batch server mode, Current OrcaSlicer Version %1%, waiting for jobs on stdin")%SoftFever_VERSION;
+
+    // One job per line: {"id": <any>, "args": ["--slice", "0", "--outputdir", "out", "model.3mf"]}, the arguments are the same
+    // as of a command line invocation. The jobs are executed one by one, each job is reported by a single line on stdout:
+    // {"id": <any>, "return_code": <int>, "time": <seconds>}, the details are recorded into result.json of the job as usual.
+    // The jobs share the process global state of the CLI, thus they are not executed concurrently, each job parallelizes
+    // its slicing internally and its models and prints are released once it finishes.
+    // The responses are written to a duplicate of the original stdout, while stdout itself is redirected to stderr
+    // for the whole session, so that the messages printed by the jobs (flush_and_exit(), printf() of the libraries ...)
+    // never end up among the responses.
+#ifdef _WIN32
+    auto dup_fd = _dup; auto dup2_fd = _dup2; auto fdopen_fd = _fdopen; auto close_fd = _close;
+#else
+    auto dup_fd = dup; auto dup2_fd = dup2; auto fdopen_fd = fdopen; auto close_fd = close;
+#endif
+    boost::nowide::cout.flush();
+    std::cout.flush();
+    fflush(stdout);
+    const int stdout_fd   = fileno(stdout);
+    const int response_fd = dup_fd(stdout_fd);
+    FILE     *responses   = response_fd == -1 ? nullptr : fdopen_fd(response_fd, "w");
+    if (responses == nullptr || dup2_fd(fileno(stderr), stdout_fd) == -1) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed to redirect stdout for the responses";
+        if (responses != nullptr)
+            fclose(responses);
+        else if (response_fd != -1)
+            close_fd(response_fd);
+        return CLI_ENVIRONMENT_ERROR;
+    }
+    s_batch_server_mode = true;
+    std::string line;
+    size_t      num_jobs = 0;
+    while (std::getline(boost::nowide::cin, line)) {
+        boost::algorithm::trim(line);
+        if (line.empty())
+            continue;
+        auto start_time = std::chrono::steady_clock::now();
+        nlohmann::json response;
+        std::vector<std::string> job_args { program_name };
+        try {
+            nlohmann::json job = nlohmann::json::parse(line);
+            if (job.contains("id"))
+                response["id"] = job["id"];
+            for (const nlohmann::json &arg : job.at("args"))
+                job_args.emplace_back(arg.get<std::string>());
+        } catch (const std::exception &ex) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": invalid job " << line << ": " << ex.what();
+            response["return_code"]  = CLI_INVALID_PARAMS;
+            response["error_string"] = ex.what();
+            job_args.clear();
+        }
+        if (! job_args.empty()) {
+            std::vector<char*> job_argv;
+            for (std::string &arg : job_args)
+                job_argv.emplace_back(arg.data());
+            job_argv.emplace_back(nullptr);
+            g_slicing_warnings.clear();
+            int ret = CLI_SUCCESS;
+            try {
+                ret = CLI().run(int(job_args.size()), job_argv.data());
+            } catch (const std::exception &ex) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": job " << line << " failed: " << ex.what();
+                ret = CLI_ENVIRONMENT_ERROR;
+                response["error_string"] = ex.what();
+            }
+            response["return_code"] = ret;
+        }
+        response["time"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        // Let the messages of the job precede its response.
+        boost::nowide::cout.flush();
+        std::cout.flush();
+        fflush(stdout);
+        fputs((response.dump() + "\n").c_str(), responses);
+        fflush(responses);
+        ++ num_jobs;
+    }
+    s_batch_server_mode = false;
+    s_settings_files_cache.clear();
+    // Restore stdout.
+    boost::nowide::cout.flush();
+    std::cout.flush();
+    fflush(stdout);
+    dup2_fd(response_fd, stdout_fd);
+    fclose(responses);
+    BOOST_LOG_TRIVIAL(warning) << boost::format("batch server finished %1% jobs")%num_jobs;
+    return CLI_SUCCESS;
+}
+
 bool CLI::setup(int argc, char **argv)
 {
     // Detect the operating system flavor after SLIC3R_LOGLEVEL is set.
@@ -7238,6 +7429,8 @@ bool CLI::export_project(Model *model, std::string& path, PlateDataPtrs &partpla
     store_params.id_bboxes = plate_bboxes;
     store_params.strategy = SaveStrategy::Silence|SaveStrategy::WithGcode|SaveStrategy::SplitModel|SaveStrategy::UseLoadedId|SaveStrategy::ShareMesh;
     store_params.export_plate_idx = plate_to_export;
+    if (const ConfigOptionInt* opt_compression = m_config.opt<ConfigOptionInt>("export_3mf_compression"))
+        store_params.compression_level = opt_compression->value;
     if (minimum_save)
         store_params.strategy = store_params.strategy | SaveStrategy::SkipModel;
 
@@ -116,6 +116,8 @@ private:
     std::vector<Model>          m_models;
 
     bool setup(int argc, char **argv);
+    // Read jobs from stdin, one command line per job, and run them one by one within this process.
+    int  run_batch_server(const std::string &program_name);
 
     /// Prints usage of the CLI.
     void print_help(bool include_print_options = false, PrinterTechnology printer_technology = ptAny) const;
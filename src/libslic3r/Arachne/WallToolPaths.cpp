@@ -876,4 +876,104 @@ WallToolPaths::ExtrusionLineSet WallToolPaths::getRegionOrder(const std::vector<
     return order_requirements;
 }
 
+bool WallToolPathsCache::Key::operator==(const Key &rhs) const
+{
+    return this->bead_width_0 == rhs.bead_width_0 && this->bead_width_x == rhs.bead_width_x && this->inset_count == rhs.inset_count &&
+           this->wall_0_inset == rhs.wall_0_inset && this->layer_height == rhs.layer_height &&
+           this->params.min_bead_width == rhs.params.min_bead_width && this->params.min_feature_size == rhs.params.min_feature_size &&
+           this->params.min_length_factor == rhs.params.min_length_factor && this->params.wall_transition_length == rhs.params.wall_transition_length &&
+           this->params.wall_transition_angle == rhs.params.wall_transition_angle &&
+           this->params.wall_transition_filter_deviation == rhs.params.wall_transition_filter_deviation &&
+           this->params.wall_distribution_count == rhs.params.wall_distribution_count &&
+           this->params.is_top_or_bottom_layer == rhs.params.is_top_or_bottom_layer &&
+           this->outline == rhs.outline;
+}
+
+size_t WallToolPathsCache::Key::hash() const
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, this->bead_width_0);
+    boost::hash_combine(seed, this->bead_width_x);
+    boost::hash_combine(seed, this->inset_count);
+    boost::hash_combine(seed, this->wall_0_inset);
+    boost::hash_combine(seed, this->layer_height);
+    boost::hash_combine(seed, this->params.min_bead_width);
+    boost::hash_combine(seed, this->params.min_feature_size);
+    boost::hash_combine(seed, this->params.min_length_factor);
+    boost::hash_combine(seed, this->params.wall_transition_length);
+    boost::hash_combine(seed, this->params.wall_transition_angle);
+    boost::hash_combine(seed, this->params.wall_transition_filter_deviation);
+    boost::hash_combine(seed, this->params.wall_distribution_count);
+    boost::hash_combine(seed, this->params.is_top_or_bottom_layer);
+    for (const Polygon &polygon : this->outline) {
+        boost::hash_combine(seed, polygon.size());
+        for (const Point &pt : polygon)
+            boost::hash_combine(seed, (uint64_t(uint32_t(pt.x())) << 32) | uint64_t(uint32_t(pt.y())));
+    }
+    return seed;
+}
+
+void WallToolPathsCache::generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset, coordf_t layer_height,
+                                  const WallToolPathsParams &params, std::vector<VariableWidthLines> &toolpaths, Polygons &inner_contour)
+{
+    const Point shift = outline.empty() ? Point::Zero() : get_extents(outline).min;
+    Key key { outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params };
+    for (Polygon &polygon : key.outline)
+        polygon.translate(- shift);
+    const size_t hash = key.hash();
+
+    auto find_entry = [this, &key, hash]() -> std::shared_ptr<const Entry> {
+        for (auto [it, end] = m_entries.equal_range(hash); it != end; ++ it)
+            if (it->second->key == key)
+                return it->second;
+        return {};
+    };
+
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry = find_entry();
+    }
+    if (! entry) {
+        // Generate outside of the lock. Two threads may generate the same entry, only the first one is kept.
+        auto new_entry = std::make_shared<Entry>();
+        WallToolPaths wall_tool_paths(key.outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, layer_height, params);
+        new_entry->toolpaths     = wall_tool_paths.getToolPaths();
+        new_entry->inner_contour = wall_tool_paths.getInnerContour();
+        new_entry->key           = std::move(key);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry = find_entry();
+        if (! entry) {
+            entry = std::move(new_entry);
+            m_entries.emplace(hash, entry);
+            m_insertion_order.emplace_back(hash, entry.get());
+            while (m_insertion_order.size() > m_max_entries) {
+                auto [oldest_hash, oldest] = m_insertion_order.front();
+                m_insertion_order.pop_front();
+                for (auto [it, end] = m_entries.equal_range(oldest_hash); it != end; ++ it)
+                    if (it->second.get() == oldest) {
+                        m_entries.erase(it);
+                        break;
+                    }
+            }
+        }
+    }
+
+    toolpaths     = entry->toolpaths;
+    inner_contour = entry->inner_contour;
+    for (VariableWidthLines &lines : toolpaths)
+        for (ExtrusionLine &line : lines)
+            for (ExtrusionJunction &junction : line.junctions)
+                junction.p += shift;
+    for (Polygon &polygon : inner_contour)
+        polygon.translate(shift);
+}
+
+void WallToolPathsCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_insertion_order.clear();
+}
+
 } // namespace Slic3r::Arachne
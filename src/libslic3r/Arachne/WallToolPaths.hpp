@@ -4,7 +4,10 @@
 #ifndef CURAENGINE_WALLTOOLPATHS_H
 #define CURAENGINE_WALLTOOLPATHS_H
 
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <ankerl/unordered_dense.h>
 
 #include "BeadingStrategy/BeadingStrategyFactory.hpp"
@@ -139,6 +142,61 @@ private:
     const WallToolPathsParams m_params;
 };
 
+/*!
+ * Cache of the toolpaths and inner contours generated by WallToolPaths, shared by the layers of an object processed in parallel.
+ * Prismatic objects have the same outlines at many layers, possibly shifted in XY, for which the Voronoi diagram and
+ * the skeletal trapezoidation are calculated just once.
+ *
+ * The outlines are processed translated to the origin of their bounding box, thus the results do not depend on whether
+ * they were taken from the cache or not.
+ */
+class WallToolPathsCache
+{
+public:
+    /*!
+     * \param max_entries Number of the most recently generated results kept. The layers of an object are processed
+     * in parallel by ranges of consecutive layers, thus the cache has to hold the islands of about one layer per worker.
+     */
+    explicit WallToolPathsCache(size_t max_entries = 64) : m_max_entries(max_entries) {}
+
+    /*!
+     * Generates the toolpaths and the inner contour as WallToolPaths(outline, ...).getToolPaths() and getInnerContour() would,
+     * or takes them over from an outline processed with the same parameters, which differed by a translation only.
+     */
+    void generate(const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset, coordf_t layer_height,
+                  const WallToolPathsParams &params, std::vector<VariableWidthLines> &toolpaths, Polygons &inner_contour);
+
+    void clear();
+
+private:
+    struct Key
+    {
+        // Translated to the origin of its bounding box.
+        Polygons            outline;
+        coord_t             bead_width_0;
+        coord_t             bead_width_x;
+        size_t              inset_count;
+        coord_t             wall_0_inset;
+        coordf_t            layer_height;
+        WallToolPathsParams params;
+
+        bool   operator==(const Key &rhs) const;
+        size_t hash() const;
+    };
+    struct Entry
+    {
+        Key                             key;
+        std::vector<VariableWidthLines> toolpaths;
+        Polygons                        inner_contour;
+    };
+
+    size_t                                                            m_max_entries;
+    std::mutex                                                        m_mutex;
+    std::unordered_multimap<size_t, std::shared_ptr<const Entry>>     m_entries;
+    // Hashes of the entries in the order of their insertion, to drop the oldest ones.
+    std::deque<std::pair<size_t, const Entry*>>                       m_insertion_order;
+};
+
 } // namespace Slic3r::Arachne
 
 #endif // CURAENGINE_WALLTOOLPATHS_H
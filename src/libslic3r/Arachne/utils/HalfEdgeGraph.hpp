@@ -5,8 +5,14 @@
 #define UTILS_HALF_EDGE_GRAPH_H
 
 
+#include <algorithm>
 #include <list>
 #include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 
@@ -15,16 +21,133 @@
 
 namespace Slic3r::Arachne
 {
+
+/*!
+ * Memory of the nodes and edges of a single HalfEdgeGraph.
+ *
+ * Elements are carved from large blocks, elements removed from the graph are recycled through free lists
+ * per element size and all the blocks are released at once together with the graph. This replaces one heap
+ * allocation per node and edge and keeps the elements created together close in memory.
+ * The arena is not synchronized, a graph is only ever built and modified by a single thread.
+ */
+class HalfEdgeGraphArena
+{
+public:
+    HalfEdgeGraphArena() = default;
+    HalfEdgeGraphArena(const HalfEdgeGraphArena &) = delete;
+    HalfEdgeGraphArena &operator=(const HalfEdgeGraphArena &) = delete;
+
+    void *allocate(size_t size)
+    {
+        size = aligned_size(size);
+        for (std::pair<size_t, FreeChunk *> &free_list : m_free_lists)
+            if (free_list.first == size && free_list.second != nullptr) {
+                FreeChunk *chunk = free_list.second;
+                free_list.second = chunk->next;
+                return chunk;
+            }
+        if (size_t(m_end - m_cursor) < size) {
+            // Start a new block, the blocks grow geometrically so that small graphs stay small.
+            size_t block_size = std::max(size, m_next_block_size);
+            m_next_block_size = std::min(2 * m_next_block_size, MAX_BLOCK_SIZE);
+            m_blocks.emplace_back(new std::byte[block_size]);
+            m_cursor = m_blocks.back().get();
+            m_end    = m_cursor + block_size;
+        }
+        void *out = m_cursor;
+        m_cursor += size;
+        return out;
+    }
+
+    void deallocate(void *ptr, size_t size)
+    {
+        size = aligned_size(size);
+        auto *chunk = static_cast<FreeChunk *>(ptr);
+        for (std::pair<size_t, FreeChunk *> &free_list : m_free_lists)
+            if (free_list.first == size) {
+                chunk->next      = free_list.second;
+                free_list.second = chunk;
+                return;
+            }
+        chunk->next = nullptr;
+        m_free_lists.emplace_back(size, chunk);
+    }
+
+private:
+    struct FreeChunk { FreeChunk *next; };
+
+    static constexpr size_t MIN_BLOCK_SIZE = 16 * 1024;
+    static constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+    // All chunks are aligned to alignof(std::max_align_t), which is guaranteed for the blocks allocated by new[].
+    static size_t aligned_size(size_t size)
+    {
+        constexpr size_t alignment = alignof(std::max_align_t);
+        return (std::max(size, sizeof(FreeChunk)) + alignment - 1) / alignment * alignment;
+    }
+
+    std::vector<std::unique_ptr<std::byte[]>>   m_blocks;
+    std::byte                                  *m_cursor { nullptr };
+    std::byte                                  *m_end { nullptr };
+    size_t                                      m_next_block_size { MIN_BLOCK_SIZE };
+    // Pairs of a chunk size and the head of the list of free chunks of that size. There are only a few distinct sizes.
+    std::vector<std::pair<size_t, FreeChunk *>> m_free_lists;
+};
+
+/*!
+ * Allocator of the node and edge lists of a HalfEdgeGraph, all copies and rebinds share the arena of the graph.
+ */
+template<typename T>
+class HalfEdgeGraphAllocator
+{
+public:
+    using value_type                             = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    explicit HalfEdgeGraphAllocator(std::shared_ptr<HalfEdgeGraphArena> arena) : m_arena(std::move(arena)) {}
+    // No move constructor: a moved-from allocator has to stay equal to its old value, it keeps sharing the arena.
+    HalfEdgeGraphAllocator(const HalfEdgeGraphAllocator &rhs) = default;
+    HalfEdgeGraphAllocator &operator=(const HalfEdgeGraphAllocator &rhs) = default;
+    template<typename U>
+    HalfEdgeGraphAllocator(const HalfEdgeGraphAllocator<U> &rhs) : m_arena(rhs.m_arena) {}
+
+    T *allocate(size_t n)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned types are not supported by HalfEdgeGraphArena");
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) { m_arena->deallocate(ptr, n * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const HalfEdgeGraphAllocator<U> &rhs) const { return m_arena == rhs.m_arena; }
+    template<typename U>
+    bool operator!=(const HalfEdgeGraphAllocator<U> &rhs) const { return m_arena != rhs.m_arena; }
+
+private:
+    template<typename U> friend class HalfEdgeGraphAllocator;
+    std::shared_ptr<HalfEdgeGraphArena> m_arena;
+};
+
 template<class node_data_t, class edge_data_t, class derived_node_t, class derived_edge_t> // types of data contained in nodes and edges
 class HalfEdgeGraph
 {
 public:
     using edge_t = derived_edge_t;
     using node_t = derived_node_t;
-    using Edges = std::list<edge_t>;
-    using Nodes = std::list<node_t>;
+    using Edges = std::list<edge_t, HalfEdgeGraphAllocator<edge_t>>;
+    using Nodes = std::list<node_t, HalfEdgeGraphAllocator<node_t>>;
+
+    HalfEdgeGraph() : HalfEdgeGraph(std::make_shared<HalfEdgeGraphArena>()) {}
+
     Edges edges;
     Nodes nodes;
+
+private:
+    explicit HalfEdgeGraph(const std::shared_ptr<HalfEdgeGraphArena> &arena)
+        : edges(HalfEdgeGraphAllocator<edge_t>(arena)), nodes(HalfEdgeGraphAllocator<node_t>(arena))
+    {}
 };
 
 } // namespace Slic3r::Arachne
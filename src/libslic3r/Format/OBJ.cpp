@@ -5,9 +5,20 @@
 #include "OBJ.hpp"
 #include "objparser.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
 #include <string>
 
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/nowide/convert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <fast_float/fast_float.h>
 
 #ifdef _WIN32
 #define DIR_SEPARATOR '\\'
@@ -21,10 +32,220 @@
 
 namespace Slic3r {
 
-bool load_obj(const char *path, TriangleMesh *meshptr, ObjInfo& obj_info, std::string &message)
+namespace {
+
+// Geometry parsed by a single thread from a block of whole lines of an OBJ file.
+struct ObjChunk
 {
-    if (meshptr == nullptr)
+    std::vector<Vec3f>   vertices;
+    // Colors of the vertices up to the last vertex with a color, the vertices without a color get UNDEFINE_COLOR.
+    std::vector<RGBA>    colors;
+    std::vector<Vec3i32> triangles;
+    // Flattened indices into triangles of the corners referenced by a negative (relative) index.
+    // These corners are indexed relative to the first vertex of this chunk until the chunks are merged.
+    std::vector<size_t>  relative_corners;
+};
+
+inline bool obj_is_ws(char c) { return c == ' ' || c == '\t'; }
+
+inline const char* obj_skip_ws(const char *p, const char *end)
+{
+    while (p != end && obj_is_ws(*p))
+        ++ p;
+    return p;
+}
+
+// Parse a whitespace delimited number the way strtod() followed by a cast to float does, independent of the locale.
+inline const char* obj_parse_float(const char *p, const char *end, float &out)
+{
+    if (p != end && *p == '+')
+        ++ p;
+    double value;
+    auto [ptr, ec] = fast_float::from_chars(p, end, value);
+    if (ec != std::errc() || (ptr != end && ! obj_is_ws(*ptr)))
+        return nullptr;
+    out = float(value);
+    return ptr;
+}
+
+// Parse a single line of an OBJ file into the chunk. Returns false if the line has to be interpreted by ObjParser,
+// which is the case for material libraries and for malformed or unsupported lines.
+bool obj_parse_line_geometry(const char *p, const char *end, ObjChunk &chunk)
+{
+    p = obj_skip_ws(p, end);
+    if (p == end)
+        return true;
+    switch (*p ++) {
+    case 'v':
+    {
+        // vt, vn and vp are only used together with materials.
+        if (p == end || ! obj_is_ws(*p))
+            return true;
+        Vec3f pt;
+        for (int i = 0; i < 3; ++ i)
+            if (p = obj_parse_float(obj_skip_ws(p, end), end, pt[i]); p == nullptr)
+                return false;
+        // Optional vertex color, r g b [a]. Anything following the color is ignored.
+        RGBA color { 0.f, 0.f, 0.f, 1.f };
+        int  num_color_channels = 0;
+        for (; num_color_channels < 4; ++ num_color_channels) {
+            if (p = obj_skip_ws(p, end); p == end)
+                break;
+            if (p = obj_parse_float(p, end, color[num_color_channels]); p == nullptr)
+                return false;
+        }
+        if (num_color_channels == 1 || num_color_channels == 2)
+            return false;
+        chunk.vertices.emplace_back(pt);
+        if (num_color_channels > 0) {
+            chunk.colors.resize(chunk.vertices.size(), UNDEFINE_COLOR);
+            chunk.colors.back() = color;
+        }
+        return true;
+    }
+    case 'f':
+    {
+        int  indices[4];
+        bool relative[4];
+        int  cnt = 0;
+        for (p = obj_skip_ws(p, end); p != end; p = obj_skip_ws(p, end)) {
+            int idx;
+            auto [ptr, ec] = std::from_chars(p, end, idx);
+            // Polygons with more than 4 vertices are reported by the serial loader.
+            if (ec != std::errc() || idx == 0 || cnt == 4)
+                return false;
+            p = ptr;
+            // Skip the texture coordinate and normal indices.
+            if (p != end && *p == '/')
+                while (p != end && (*p == '/' || *p == '-' || (*p >= '0' && *p <= '9')))
+                    ++ p;
+            if (p != end && ! obj_is_ws(*p))
+                return false;
+            relative[cnt] = idx < 0;
+            indices[cnt ++] = idx < 0 ? int(chunk.vertices.size()) + idx : idx - 1;
+        }
+        if (cnt < 3)
+            return false;
+        auto add_triangle = [&chunk, &indices, &relative](int a, int b, int c) {
+            size_t first = chunk.triangles.size() * 3;
+            chunk.triangles.emplace_back(indices[a], indices[b], indices[c]);
+            int corners[3] = { a, b, c };
+            for (int i = 0; i < 3; ++ i)
+                if (relative[corners[i]])
+                    chunk.relative_corners.emplace_back(first + i);
+        };
+        add_triangle(0, 1, 2);
+        if (cnt == 4)
+            add_triangle(0, 2, 3);
+        return true;
+    }
+    case 'm':
+        // mtllib, materials are resolved by the serial loader.
+        return end - p < 5 || strncmp(p, "tllib", 5) != 0;
+    default:
+        // Comments, objects, groups, smoothing groups and material references without a material library.
+        return true;
+    }
+}
+
+// Load the geometry and the vertex colors of an OBJ file into an indexed triangle set without going through ObjParser::ObjData.
+// The file is memory mapped and split at line boundaries into blocks parsed in parallel, the blocks are then merged
+// in parallel, resolving the negative vertex indices.
+// Returns false if the file has to be loaded by load_obj_serial(): if it references a material library,
+// if it contains a line the fast path does not understand or if it references a vertex out of range.
+bool load_obj_parallel(const char *path, indexed_triangle_set &its, std::vector<RGBA> &vertex_colors)
+{
+    boost::iostreams::mapped_file_source mapped;
+    try {
+#ifdef _WIN32
+        mapped.open(boost::nowide::widen(path));
+#else
+        mapped.open(path);
+#endif
+    } catch (const std::exception &) {
         return false;
+    }
+    if (! mapped.is_open() || mapped.size() == 0)
+        return false;
+
+    // Split the file into blocks of about 1MB, each starting at the beginning of a line.
+    const char           *data       = mapped.data();
+    const size_t          size       = mapped.size();
+    constexpr size_t      chunk_size = 1024 * 1024;
+    std::vector<size_t>   chunk_begins { 0 };
+    for (size_t begin = chunk_size; begin < size; begin += chunk_size) {
+        begin = std::max(begin, chunk_begins.back() + 1);
+        while (begin < size && data[begin - 1] != '\n' && data[begin - 1] != '\r')
+            ++ begin;
+        if (begin < size)
+            chunk_begins.emplace_back(begin);
+    }
+    chunk_begins.emplace_back(size);
+
+    std::vector<ObjChunk> chunks(chunk_begins.size() - 1);
+    std::atomic<bool>     fallback { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t chunk_id = range.begin(); chunk_id < range.end() && ! fallback; ++ chunk_id) {
+            const char *end = data + chunk_begins[chunk_id + 1];
+            for (const char *line = data + chunk_begins[chunk_id]; line < end;) {
+                const char *eol = line;
+                while (eol != end && *eol != '\n' && *eol != '\r')
+                    ++ eol;
+                if (! obj_parse_line_geometry(line, eol, chunks[chunk_id])) {
+                    fallback = true;
+                    return;
+                }
+                line = eol + 1;
+            }
+        }
+    });
+    if (fallback)
+        return false;
+
+    // Offsets of the chunks in the merged vertex and triangle arrays.
+    std::vector<std::pair<size_t, size_t>> offsets;
+    offsets.reserve(chunks.size() + 1);
+    offsets.emplace_back(0, 0);
+    bool has_colors = false;
+    for (const ObjChunk &chunk : chunks) {
+        offsets.emplace_back(offsets.back().first + chunk.vertices.size(), offsets.back().second + chunk.triangles.size());
+        has_colors |= ! chunk.colors.empty();
+    }
+    const int num_vertices = int(offsets.back().first);
+    its.vertices.resize(offsets.back().first);
+    its.indices.resize(offsets.back().second);
+    if (has_colors)
+        vertex_colors.assign(its.vertices.size(), UNDEFINE_COLOR);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t chunk_id = range.begin(); chunk_id < range.end(); ++ chunk_id) {
+            ObjChunk &chunk = chunks[chunk_id];
+            auto [vertex_offset, triangle_offset] = offsets[chunk_id];
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(), its.vertices.begin() + vertex_offset);
+            for (size_t i = 0; i < chunk.colors.size(); ++ i)
+                for (size_t c = 0; c < 4; ++ c)
+                    vertex_colors[vertex_offset + i][c] = std::clamp(chunk.colors[i][c], 0.f, 1.f);
+            for (size_t corner : chunk.relative_corners)
+                chunk.triangles[corner / 3][corner % 3] += int(vertex_offset);
+            for (const Vec3i32 &triangle : chunk.triangles)
+                for (int i = 0; i < 3; ++ i)
+                    if (triangle[i] < 0 || triangle[i] >= num_vertices)
+                        fallback = true;
+            std::copy(chunk.triangles.begin(), chunk.triangles.end(), its.indices.begin() + triangle_offset);
+            chunk = ObjChunk();
+        }
+    });
+    if (fallback) {
+        its.clear();
+        vertex_colors.clear();
+        return false;
+    }
+    return true;
+}
+
+// Load an OBJ file through ObjParser, resolving the materials and the texture coordinates.
+bool load_obj_serial(const char *path, indexed_triangle_set &its, ObjInfo &obj_info, std::string &message)
+{
     // Parse the OBJ file.
     ObjParser::ObjData data;
     ObjParser::MtlData mtl_data;
@@ -92,7 +313,6 @@ bool load_obj(const char *path, TriangleMesh *meshptr, ObjInfo& obj_info, std::s
         }
     }
     // Convert ObjData into indexed triangle set.
-    indexed_triangle_set its;
     size_t               num_vertices = data.coordinates.size() / OBJ_VERTEX_LENGTH;
     its.vertices.reserve(num_vertices);
     its.indices.reserve(num_faces + num_quads);
@@ -201,6 +421,19 @@ bool load_obj(const char *path, TriangleMesh *meshptr, ObjInfo& obj_info, std::s
                 }
             }
         }
+    return true;
+}
+
+} // namespace
+
+bool load_obj(const char *path, TriangleMesh *meshptr, ObjInfo& obj_info, std::string &message)
+{
+    if (meshptr == nullptr)
+        return false;
+
+    indexed_triangle_set its;
+    if (! load_obj_parallel(path, its, obj_info.vertex_colors) && ! load_obj_serial(path, its, obj_info, message))
+        return false;
 
     *meshptr = TriangleMesh(std::move(its));
     if (meshptr->empty()) {
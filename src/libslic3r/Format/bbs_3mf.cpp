@@ -15,6 +15,7 @@
 #include "bbs_3mf.hpp"
 
 #include <limits>
+#include <optional>
 #include <stdexcept>
 #include <iomanip>
 
@@ -29,6 +30,8 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/convert.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/spirit/include/karma.hpp>
 #include <boost/spirit/include/qi_int.hpp>
 #include <boost/log/trivial.hpp>
@@ -466,6 +469,61 @@ bool bbs_get_attribute_value_bool(const char** attributes, unsigned int attribut
     return (text != nullptr) ? (bool)::atoi(text) : true;
 }
 
+// The <vertex> and <triangle> elements make up most of a model file, thus their attributes are collected
+// in a single pass instead of looking them up one by one. Missing values are set equal to ZERO.
+static Slic3r::Vec3f bbs_get_vertex_attributes(const char** attributes, unsigned int attributes_size)
+{
+    Slic3r::Vec3f vertex = Slic3r::Vec3f::Zero();
+    if ((attributes == nullptr) || (attributes_size % 2 != 0))
+        return vertex;
+
+    for (unsigned int a = 0; a < attributes_size; a += 2) {
+        // X_ATTR, Y_ATTR, Z_ATTR
+        const char *key = attributes[a];
+        if (key[0] >= 'x' && key[0] <= 'z' && key[1] == '\0') {
+            const char *text = attributes[a + 1];
+            fast_float::from_chars(text, text + strlen(text), vertex[key[0] - 'x']);
+        }
+    }
+    return vertex;
+}
+
+struct TriangleAttributes
+{
+    Slic3r::Vec3i32  indices          { Slic3r::Vec3i32::Zero() };
+    const char      *custom_supports  { "" };
+    const char      *custom_seam      { "" };
+    const char      *mmu_segmentation { "" };
+    const char      *fuzzy_skin       { "" };
+    const char      *face_property    { "" };
+};
+
+static TriangleAttributes bbs_get_triangle_attributes(const char** attributes, unsigned int attributes_size)
+{
+    TriangleAttributes triangle;
+    if ((attributes == nullptr) || (attributes_size % 2 != 0))
+        return triangle;
+
+    for (unsigned int a = 0; a < attributes_size; a += 2) {
+        const char *key  = attributes[a];
+        const char *text = attributes[a + 1];
+        if (key[0] == 'v' && key[1] >= '1' && key[1] <= '3' && key[2] == '\0')
+            // V1_ATTR, V2_ATTR, V3_ATTR
+            boost::spirit::qi::parse(text, text + strlen(text), boost::spirit::qi::int_, triangle.indices[key[1] - '1']);
+        else if (::strcmp(key, CUSTOM_SUPPORTS_ATTR) == 0)
+            triangle.custom_supports = text;
+        else if (::strcmp(key, CUSTOM_SEAM_ATTR) == 0)
+            triangle.custom_seam = text;
+        else if (::strcmp(key, MMU_SEGMENTATION_ATTR) == 0)
+            triangle.mmu_segmentation = text;
+        else if (::strcmp(key, CUSTOM_FUZZY_SKIN_ATTR) == 0)
+            triangle.fuzzy_skin = text;
+        else if (::strcmp(key, FACE_PROPERTY_ATTR) == 0)
+            triangle.face_property = text;
+    }
+    return triangle;
+}
+
 void add_vec3(std::stringstream &stream, const Slic3r::Vec3f &tr)
 {
     for (unsigned r = 0; r < 3; ++r) {
@@ -1044,6 +1102,14 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::vector<ObjectImporter*> m_object_importers;
 
         std::map<int, ModelVolume*> m_shared_meshes;
+        // Meshes of the sub-objects built in parallel by _prepare_volume_meshes(), consumed by _generate_volumes_new().
+        struct PreparedMesh
+        {
+            bool                        valid { false };
+            TriangleMesh                mesh;
+            std::optional<TriangleMesh> convex_hull;
+        };
+        std::map<Id, PreparedMesh> m_prepared_meshes;
 
         //BBS: plater related structures
         bool m_is_bbl_3mf { false };
@@ -1215,6 +1281,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         bool _handle_start_relationship(const char** attributes, unsigned int num_attributes);
 
         void _generate_current_object_list(std::vector<Component> &sub_objects, Id object_id, IdToCurrentObjectMap& current_objects);
+        void _prepare_volume_meshes(const std::vector<Id> &sub_objects);
         bool _generate_volumes_new(ModelObject& object, const std::vector<Component> &sub_objects, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions);
         //bool _generate_volumes(ModelObject& object, const Geometry& geometry, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions);
 
@@ -1253,6 +1320,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         m_current_objects.clear();
         m_index_paths.clear();
         m_objects.clear();
+        m_prepared_meshes.clear();
         m_instances.clear();
         m_objects_metadata.clear();
         m_curr_metadata_name.clear();
@@ -1947,6 +2015,19 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 current_plate_data = it->second;
             }
         }
+        {
+            // Build the meshes of all the objects to be loaded in parallel, they are assembled into the model below in the order of the objects.
+            std::vector<Id> sub_objects;
+            for (const IdToModelObjectMap::value_type& object : m_objects) {
+                if (current_plate_data && current_plate_data->obj_inst_map.find(object.first.second) == current_plate_data->obj_inst_map.end())
+                    continue;
+                std::vector<Component> object_id_list;
+                _generate_current_object_list(object_id_list, object.first, m_current_objects);
+                for (const Component &component : object_id_list)
+                    sub_objects.emplace_back(component.object_id);
+            }
+            _prepare_volume_meshes(sub_objects);
+        }
         for (const IdToModelObjectMap::value_type& object : m_objects) {
             if (object.second >= int(m_model->objects.size())) {
                 add_error("invalid object, id: "+std::to_string(object.first.second));
@@ -2067,6 +2148,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
         }
 
+        // Meshes of the sub-objects shared by multiple volumes are not consumed.
+        m_prepared_meshes.clear();
+
         // If instances contain a single volume, the volume offset should be 0,0,0
         // This equals to say that instance world position and volume world position should match
         // Correct all instances/volumes for which this does not hold
@@ -3583,10 +3667,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the vertex coordinates
         // missing values are set equal to ZERO
         if (m_curr_object)
-            m_curr_object->geometry.vertices.emplace_back(
-                m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, X_ATTR),
-                m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Y_ATTR),
-                m_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+            m_curr_object->geometry.vertices.emplace_back(m_unit_factor * bbs_get_vertex_attributes(attributes, num_attributes));
         return true;
     }
 
@@ -3622,17 +3703,15 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
         if (m_curr_object) {
-            m_curr_object->geometry.triangles.emplace_back(
-                bbs_get_attribute_value_int(attributes, num_attributes, V1_ATTR),
-                bbs_get_attribute_value_int(attributes, num_attributes, V2_ATTR),
-                bbs_get_attribute_value_int(attributes, num_attributes, V3_ATTR));
-
-            m_curr_object->geometry.custom_supports.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR));
-            m_curr_object->geometry.custom_seam.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_SEAM_ATTR));
-            m_curr_object->geometry.mmu_segmentation.push_back(bbs_get_attribute_value_string(attributes, num_attributes, MMU_SEGMENTATION_ATTR));
-            m_curr_object->geometry.fuzzy_skin.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_FUZZY_SKIN_ATTR));
+            TriangleAttributes triangle = bbs_get_triangle_attributes(attributes, num_attributes);
+            m_curr_object->geometry.triangles.emplace_back(triangle.indices);
+
+            m_curr_object->geometry.custom_supports.emplace_back(triangle.custom_supports);
+            m_curr_object->geometry.custom_seam.emplace_back(triangle.custom_seam);
+            m_curr_object->geometry.mmu_segmentation.emplace_back(triangle.mmu_segmentation);
+            m_curr_object->geometry.fuzzy_skin.emplace_back(triangle.fuzzy_skin);
             // BBS
-            m_curr_object->geometry.face_properties.push_back(bbs_get_attribute_value_string(attributes, num_attributes, FACE_PROPERTY_ATTR));
+            m_curr_object->geometry.face_properties.emplace_back(triangle.face_property);
         }
         return true;
     }
@@ -4663,6 +4742,47 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
     }
 
+    void _BBS_3MF_Importer::_prepare_volume_meshes(const std::vector<Id> &sub_objects)
+    {
+        std::vector<std::pair<const CurrentObject*, PreparedMesh*>> meshes;
+        for (const Id &id : sub_objects) {
+            IdToCurrentObjectMap::const_iterator current_object = m_current_objects.find(id);
+            // Skip the meshes already loaded, they will be shared.
+            if (current_object != m_current_objects.end() && m_shared_meshes.find(id.second) == m_shared_meshes.end() && m_prepared_meshes.find(id) == m_prepared_meshes.end())
+                meshes.emplace_back(&current_object->second, &m_prepared_meshes[id]);
+        }
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, meshes.size(), 1), [&meshes](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                const Geometry &geometry = meshes[i].first->geometry;
+                PreparedMesh   &prepared = *meshes[i].second;
+                // Invalid geometries are reported by _generate_volumes_new().
+                if (geometry.triangles.empty() || std::any_of(geometry.triangles.begin(), geometry.triangles.end(), [num_vertices = int(geometry.vertices.size())](const Vec3i32 &face) {
+                        return (face.array() < 0).any() || (face.array() >= num_vertices).any(); }))
+                    continue;
+
+                indexed_triangle_set its;
+                its.indices.assign(geometry.triangles.begin(), geometry.triangles.end());
+                its.vertices.assign(geometry.vertices.begin(), geometry.vertices.end());
+                // BBS
+                its.properties.reserve(geometry.face_properties.size());
+                for (const std::string& prop_str : geometry.face_properties) {
+                    FaceProperty face_prop;
+                    face_prop.from_string(prop_str);
+                    its.properties.push_back(face_prop);
+                }
+
+                prepared.mesh = TriangleMesh(std::move(its));
+                if (prepared.mesh.volume() < 0)
+                    prepared.mesh.flip_triangles();
+                // Same condition as in the ModelVolume constructor.
+                if (prepared.mesh.facets_count() > 1)
+                    prepared.convex_hull = prepared.mesh.convex_hull_3d();
+                prepared.valid = true;
+            }
+        });
+    }
+
     bool _BBS_3MF_Importer::_generate_volumes_new(ModelObject& object, const std::vector<Component> &sub_objects, const ObjectMetadata::VolumeMetadataList& volumes, ConfigSubstitutionContext& config_substitutions)
     {
         if (!object.volumes.empty()) {
@@ -4750,49 +4870,58 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 return false;
             }
             if (!shared_volume){
-                // splits volume out of imported geometry
-                indexed_triangle_set its;
-                its.indices.assign(sub_object->geometry.triangles.begin(), sub_object->geometry.triangles.end());
-                //const size_t triangles_count = its.indices.size();
-                //if (triangles_count == 0) {
-                //    add_error("found no trianges in the object " + std::to_string(sub_object->id));
-                //    return false;
-                //}
-                for (const Vec3i32& face : its.indices) {
-                    for (const int tri_id : face) {
-                        if (tri_id < 0 || tri_id >= int(sub_object->geometry.vertices.size())) {
-                            add_error("invalid vertex id in object " + std::to_string(sub_object->id));
-                            return false;
+                TriangleMesh                triangle_mesh;
+                std::optional<TriangleMesh> convex_hull;
+                if (auto prepared = m_prepared_meshes.find(object_id); prepared != m_prepared_meshes.end() && prepared->second.valid) {
+                    triangle_mesh = std::move(prepared->second.mesh);
+                    triangle_mesh.set_repaired_errors(volume_data->mesh_stats);
+                    convex_hull = std::move(prepared->second.convex_hull);
+                    m_prepared_meshes.erase(prepared);
+                } else {
+                    // splits volume out of imported geometry
+                    indexed_triangle_set its;
+                    its.indices.assign(sub_object->geometry.triangles.begin(), sub_object->geometry.triangles.end());
+                    //const size_t triangles_count = its.indices.size();
+                    //if (triangles_count == 0) {
+                    //    add_error("found no trianges in the object " + std::to_string(sub_object->id));
+                    //    return false;
+                    //}
+                    for (const Vec3i32& face : its.indices) {
+                        for (const int tri_id : face) {
+                            if (tri_id < 0 || tri_id >= int(sub_object->geometry.vertices.size())) {
+                                add_error("invalid vertex id in object " + std::to_string(sub_object->id));
+                                return false;
+                            }
                         }
                     }
-                }
 
-                its.vertices.assign(sub_object->geometry.vertices.begin(), sub_object->geometry.vertices.end());
+                    its.vertices.assign(sub_object->geometry.vertices.begin(), sub_object->geometry.vertices.end());
 
-                // BBS
-                for (const std::string& prop_str : sub_object->geometry.face_properties) {
-                    FaceProperty face_prop;
-                    face_prop.from_string(prop_str);
-                    its.properties.push_back(face_prop);
-                }
+                    // BBS
+                    for (const std::string& prop_str : sub_object->geometry.face_properties) {
+                        FaceProperty face_prop;
+                        face_prop.from_string(prop_str);
+                        its.properties.push_back(face_prop);
+                    }
 
-                TriangleMesh triangle_mesh(std::move(its), volume_data->mesh_stats);
+                    triangle_mesh = TriangleMesh(std::move(its), volume_data->mesh_stats);
 
-                // BBS: no need to multiply the instance matrix into the volume
-                //if (!m_is_bbl_3mf) {
-                //    // if the 3mf was not produced by BambuStudio and there is only one instance,
-                //    // bake the transformation into the geometry to allow the reload from disk command
-                //    // to work properly
-                //    if (object.instances.size() == 1) {
-                //        triangle_mesh.transform(object.instances.front()->get_transformation().get_matrix(), false);
-                //        object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
-                //        //FIXME do the mesh fixing?
-                //    }
-                //}
-                if (triangle_mesh.volume() < 0)
-                    triangle_mesh.flip_triangles();
+                    // BBS: no need to multiply the instance matrix into the volume
+                    //if (!m_is_bbl_3mf) {
+                    //    // if the 3mf was not produced by BambuStudio and there is only one instance,
+                    //    // bake the transformation into the geometry to allow the reload from disk command
+                    //    // to work properly
+                    //    if (object.instances.size() == 1) {
+                    //        triangle_mesh.transform(object.instances.front()->get_transformation().get_matrix(), false);
+                    //        object.instances.front()->set_transformation(Slic3r::Geometry::Transformation());
+                    //        //FIXME do the mesh fixing?
+                    //    }
+                    //}
+                    if (triangle_mesh.volume() < 0)
+                        triangle_mesh.flip_triangles();
+                }
 
-                volume = object.add_volume(std::move(triangle_mesh));
+                volume = convex_hull ? object.add_volume(std::move(triangle_mesh), std::move(*convex_hull)) : object.add_volume(std::move(triangle_mesh));
 
                 if (shared_mesh_id != -1)
                     //for some cases the shared mesh is in other plate and not loaded in cli slicing
@@ -4810,7 +4939,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             if (has_transform)
                 volume->source.transform = Slic3r::Geometry::Transformation(volume_matrix_to_object);
 
-            volume->calculate_convex_hull();
+            // A new volume got its convex hull when it was created.
+            if (shared_volume || ! volume->get_convex_hull_shared_ptr())
+                volume->calculate_convex_hull();
 
             //set transform from 3mf
             Slic3r::Geometry::Transformation comp_transformatino(sub_comp.transform);
@@ -5259,10 +5390,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the vertex coordinates
         // missing values are set equal to ZERO
         if (current_object)
-            current_object->geometry.vertices.emplace_back(
-                object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, X_ATTR),
-                object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Y_ATTR),
-                object_unit_factor * bbs_get_attribute_value_float(attributes, num_attributes, Z_ATTR));
+            current_object->geometry.vertices.emplace_back(object_unit_factor * bbs_get_vertex_attributes(attributes, num_attributes));
         return true;
     }
 
@@ -5298,17 +5426,15 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         // appends the triangle's vertices indices
         // missing values are set equal to ZERO
         if (current_object) {
-            current_object->geometry.triangles.emplace_back(
-                bbs_get_attribute_value_int(attributes, num_attributes, V1_ATTR),
-                bbs_get_attribute_value_int(attributes, num_attributes, V2_ATTR),
-                bbs_get_attribute_value_int(attributes, num_attributes, V3_ATTR));
-
-            current_object->geometry.custom_supports.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_SUPPORTS_ATTR));
-            current_object->geometry.custom_seam.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_SEAM_ATTR));
-            current_object->geometry.mmu_segmentation.push_back(bbs_get_attribute_value_string(attributes, num_attributes, MMU_SEGMENTATION_ATTR));
-            current_object->geometry.fuzzy_skin.push_back(bbs_get_attribute_value_string(attributes, num_attributes, CUSTOM_FUZZY_SKIN_ATTR));
+            TriangleAttributes triangle = bbs_get_triangle_attributes(attributes, num_attributes);
+            current_object->geometry.triangles.emplace_back(triangle.indices);
+
+            current_object->geometry.custom_supports.emplace_back(triangle.custom_supports);
+            current_object->geometry.custom_seam.emplace_back(triangle.custom_seam);
+            current_object->geometry.mmu_segmentation.emplace_back(triangle.mmu_segmentation);
+            current_object->geometry.fuzzy_skin.emplace_back(triangle.fuzzy_skin);
             // BBS
-            current_object->geometry.face_properties.push_back(bbs_get_attribute_value_string(attributes, num_attributes, FACE_PROPERTY_ATTR));
+            current_object->geometry.face_properties.emplace_back(triangle.face_property);
         }
         return true;
     }
@@ -5612,6 +5738,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         bool m_skip_auxiliary { false };    // skip normal axuiliary files
         bool m_use_loaded_id { false };        // whether to use loaded id for identify_id
         bool m_share_mesh { false };        // whether to share mesh between objects
+        int  m_compression_level { MZ_DEFAULT_COMPRESSION }; // deflate level of the zip entries, 0 stores them uncompressed
         std::string m_thumbnail_middle = PRINTER_THUMBNAIL_MIDDLE_FILE;
         std::string m_thumbnail_small  = PRINTER_THUMBNAIL_SMALL_FILE;
         std::map<void const *, std::pair<ObjectData*, ModelVolume const *>> m_shared_meshes;
@@ -5710,6 +5837,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         m_from_backup_save = store_params.strategy & SaveStrategy::Backup;
 
         m_use_loaded_id = store_params.strategy & SaveStrategy::UseLoadedId;
+        m_compression_level = std::clamp(store_params.compression_level, int(MZ_DEFAULT_COMPRESSION), int(MZ_BEST_COMPRESSION));
 
         if (auto info = store_params.model->model_info) {
             if (auto iter = info->metadata_items.find("Thumbnail_Small"); iter != info->metadata_items.end())
@@ -6167,7 +6295,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     plate_data->gcode_file_md5 = std::string(md5_str);
                     std::string target_file    = (boost::format("Metadata/plate_%1%.gcode.md5") % (plate_data->plate_index + 1)).str();
                     if (!mz_zip_writer_add_mem(&archive, target_file.c_str(), (const void *) plate_data->gcode_file_md5.c_str(), plate_data->gcode_file_md5.length(),
-                                               MZ_DEFAULT_COMPRESSION)) {
+                                               m_compression_level)) {
                         BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__
                                                  << boost::format(", store  gcode md5 to 3mf's %1%,  length %2%, failed\n") %target_file %plate_data->gcode_file_md5.length();
                         return false;
@@ -6296,7 +6424,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add content types file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add content types file to archive\n");
             return false;
@@ -6399,7 +6527,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         std::string out = j.dump();
 
         std::string json_file_name = (boost::format(PATTERN_CONFIG_FILE_FORMAT) % (index + 1)).str();
-        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, json_file_name.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add json file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add json file to archive\n");
             return false;
@@ -6472,7 +6600,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, from.empty() ? RELATIONSHIPS_FILE.c_str() : from.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add relationships file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add relationships file to archive\n");
             return false;
@@ -6521,9 +6649,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 // GH issue #6193.
                 (uint64_t(1) << 32) - 1,
 #if WRITE_ZIP_LANGUAGE_ENCODING
-            nullptr, nullptr, 0, MZ_DEFAULT_LEVEL, nullptr, 0, nullptr, 0)) {
+            nullptr, nullptr, 0, mz_uint(m_compression_level), nullptr, 0, nullptr, 0)) {
 #else
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
+            nullptr, nullptr, 0, mz_uint(m_compression_level), extra.c_str(), extra.length(), extra.c_str(), extra.length())) {
 #endif
             add_error("Unable to add model file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add model file to archive\n");
@@ -7228,7 +7356,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add cut information file to archive");
                 return false;
             }
@@ -7262,7 +7390,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7321,7 +7449,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add layer heights profile file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add layer heights profile file to archive\n");
                 return false;
@@ -7357,7 +7485,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             out = std::string("brim_points_format_version=") + std::to_string(brim_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BRIM_EAR_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add brim ear points file to archive");
                 return false;
             }
@@ -7393,7 +7521,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7445,7 +7573,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             // Adds version header at the beginning:
             //out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(m_compression_level))) {
                 add_error("Unable to add sla support points file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add sla support points file to archive\n");
                 return false;
@@ -7466,7 +7594,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 out += "; " + key + " = " + config.opt_serialize(key) + "\n";
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!mz_zip_writer_add_mem(&archive, BBS_PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
                 add_error("Unable to add print config file to archive");
                 BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add print config file to archive\n");
                 return false;
@@ -7854,7 +7982,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         stream << "</" << CONFIG_TAG << ">\n";
 
         std::string out = stream.str();
-        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, BBS_MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format("Unable to add model config file to archive\n");
             add_error("Unable to add model config file to archive");
             return false;
@@ -8009,7 +8137,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, SLICE_INFO_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add model config file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", store  slice-info to 3mf,  length %1%, failed\n") % out.length();
             return false;
@@ -8046,24 +8174,30 @@ bool _BBS_3MF_Exporter::_add_gcode_file_to_archive(mz_zip_archive& archive, cons
 
             plate_data->gcode_file = gcode_in_3mf;
             mz_zip_archive archive;
-            mz_zip_writer_staged_context context;
             mz_zip_zero_struct(&archive);
             mz_zip_writer_init_heap(&archive, 0, 1024 * 1024);
             {
-                mz_zip_writer_add_staged_open(&archive, &context, gcode_in_3mf.c_str(), m_zip64 ? (uint64_t(1) << 30) * 16 : (uint64_t(1) << 32) - 1, nullptr, nullptr, 0,
-                    MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0);
-                boost::filesystem::path src_gcode_path(src_gcode_file);
-                if (!boost::filesystem::exists(src_gcode_path)) {
-                    BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << src_gcode_file;
-                    result = false;
+                // Map the G-code into memory and deflate it in parallel chunks, the G-code of a single plate may take hundreds of MB.
+                // An empty G-code is stored as an empty entry, a file of zero bytes cannot be mapped.
+                boost::iostreams::mapped_file_source gcode_mapped;
+                boost::system::error_code            ec;
+                if (boost::filesystem::file_size(src_gcode_file, ec) > 0 || ec) {
+                    try {
+#ifdef _WIN32
+                        gcode_mapped.open(boost::nowide::widen(src_gcode_file));
+#else
+                        gcode_mapped.open(src_gcode_file);
+#endif
+                    } catch (const std::exception &err) {
+                        BOOST_LOG_TRIVIAL(error) << "Gcode is missing, filename = " << src_gcode_file << ", " << err.what();
+                        result = false;
+                    }
                 }
-                boost::filesystem::ifstream ifs(src_gcode_file, std::ios::binary);
-                std::string buf(64 * 1024, 0);
-                while (ifs) {
-                    ifs.read(buf.data(), buf.size());
-                    mz_zip_writer_add_staged_data(&context, buf.data(), ifs.gcount());
+                if (!zip_writer_add_mem_parallel(&archive, gcode_in_3mf.c_str(), gcode_mapped.is_open() ? gcode_mapped.data() : nullptr,
+                        gcode_mapped.is_open() ? gcode_mapped.size() : 0, mz_uint(m_compression_level))) {
+                    BOOST_LOG_TRIVIAL(error) << "Unable to add gcode to 3mf, filename = " << src_gcode_file;
+                    result = false;
                 }
-                mz_zip_writer_add_staged_finish(&context);
             }
             void *ppBuf; size_t pSize;
             mz_zip_writer_finalize_heap_archive(&archive, &ppBuf, &pSize);
@@ -8128,7 +8262,7 @@ bool _BBS_3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive(mz_zip_arc
     }
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), m_compression_level)) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ":" << __LINE__ << boost::format(", Unable to add custom Gcodes per print_z file to archive\n");
             return false;
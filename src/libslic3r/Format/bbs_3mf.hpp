@@ -239,6 +239,8 @@ struct StoreParams
     std::vector<PlateBBoxData*> id_bboxes;
     BBLProject* project = nullptr;
     BBLProfile* profile = nullptr;
+    // Deflate level of the model and G-code entries: -1 for the miniz default, 0 to store without compression, 1 to 9.
+    int compression_level = -1;
 
     StoreParams() {}
 };
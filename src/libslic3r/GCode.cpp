@@ -3526,6 +3526,44 @@ size_t GCode::get_extruder_id(unsigned int filament_id) const
     return 0;
 }
 
+// Clear the extrusions of the object and support layers of an exported print_z, see Print::release_extrusions_on_export().
+static void release_layer_extrusions(const std::vector<GCode::LayerToPrint> &layers)
+{
+    for (const GCode::LayerToPrint &layer_to_print : layers) {
+        if (layer_to_print.object_layer)
+            for (LayerRegion *layerm : const_cast<Layer*>(layer_to_print.object_layer)->regions()) {
+                layerm->perimeters.clear();
+                layerm->thin_fills.clear();
+                layerm->fills.clear();
+            }
+        if (layer_to_print.support_layer)
+            const_cast<SupportLayer*>(layer_to_print.support_layer)->support_fills.clear();
+    }
+}
+
+GCode::PreparedLayer GCode::prepare_layer(const std::vector<LayerToPrint> &layers, size_t layer_to_print_idx, bool reduce_crossing_wall)
+{
+    PreparedLayer out;
+    out.layer_to_print_idx = layer_to_print_idx;
+    out.travel_data.reserve(layers.size());
+    out.quality_data.reserve(layers.size());
+    for (const LayerToPrint &layer_to_print : layers) {
+        const Layer *layer = layer_to_print.layer();
+        out.travel_data.emplace_back(reduce_crossing_wall && layer ? AvoidCrossingPerimeters::prepare_layer(*layer) : nullptr);
+        std::optional<ExtrusionQualityEstimator::LayerData> quality_data;
+        if (layer_to_print.object_layer) {
+            const auto& regions = layer_to_print.object_layer->regions();
+            const bool  enable_overhang_speed = std::any_of(regions.begin(), regions.end(), [](const LayerRegion* r) {
+                return r->has_extrusions() && r->region().config().enable_overhang_speed;
+            });
+            if (enable_overhang_speed)
+                quality_data = ExtrusionQualityEstimator::prepare_layer(*layer_to_print.object_layer);
+        }
+        out.quality_data.emplace_back(std::move(quality_data));
+    }
+    return out;
+}
+
 // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
 // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
 // and export G-code into file.
@@ -3538,28 +3576,42 @@ void GCode::process_layers(
 {
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerResult {
-            if (layer_to_print_idx >= layers_to_print.size()) {
-                if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
-                    fc.stop();
-                    return {};
-                } else {
-                    // Pressure equalizer need insert empty input. Because it returns one layer back.
-                    // Insert NOP (no operation) layer;
-                    ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
-                }
+    const auto layer_selector = tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> size_t {
+            // Pressure equalizer need insert empty input. Because it returns one layer back.
+            if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0))
+                fc.stop();
+            return layer_to_print_idx ++;
+        });
+    // Build the layer data, which does not depend on the state of the G-code generator, for several layers ahead in parallel.
+    const auto layer_preparer = tbb::make_filter<size_t, PreparedLayer>(slic3r_tbb_filtermode::parallel,
+        [&layers_to_print, reduce_crossing_wall = m_config.reduce_crossing_wall.value](size_t idx) -> PreparedLayer {
+            return idx < layers_to_print.size() ? prepare_layer(layers_to_print[idx].second, idx, reduce_crossing_wall) : PreparedLayer{ idx };
+        });
+    // Shared objects point to the layers of the object they share, all of them are printed within the same entry
+    // of layers_to_print. The generator is serial, thus once it starts a layer, the layers two entries below are
+    // no longer referenced (the layer right below provides the overhang and curled edge estimation).
+    const bool release_extrusions = print.release_extrusions_on_export();
+    const auto generator = tbb::make_filter<PreparedLayer, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, release_extrusions](PreparedLayer prepared_layer) -> LayerResult {
+            const size_t idx = prepared_layer.layer_to_print_idx;
+            if (idx >= layers_to_print.size()) {
+                // Insert NOP (no operation) layer;
+                return LayerResult::make_nop_layer_result();
             } else {
-                const std::pair<coordf_t, std::vector<LayerToPrint>>& layer = layers_to_print[layer_to_print_idx++];
+                if (release_extrusions && idx >= 2) {
+                    release_layer_extrusions(layers_to_print[idx - 2].second);
+                    m_released_extrusions = true;
+                }
+                const std::pair<coordf_t, std::vector<LayerToPrint>>& layer = layers_to_print[idx];
                 const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
-                print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(layer_to_print_idx)));
+                print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(idx + 1)));
                 if (m_wipe_tower && layer_tools.has_wipe_tower)
                     m_wipe_tower->next_layer();
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, tool_ordering.get_most_used_extruder(), size_t(-1));
+                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, tool_ordering.get_most_used_extruder(), size_t(-1), false, &prepared_layer);
             }
         });
     if (m_spiral_vase) {
@@ -3618,13 +3670,13 @@ void GCode::process_layers(
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & spiral_mode & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & cooling & fan_mover & pa_processor_filter & output);
 
 }
 
@@ -3642,25 +3694,31 @@ void GCode::process_layers(
 {
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx, prime_extruder](tbb::flow_control& fc) -> LayerResult {
-            if (layer_to_print_idx >= layers_to_print.size()) {
-                if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0)) {
-                    fc.stop();
-                    return {};
-                } else {
-                    // Pressure equalizer need insert empty input. Because it returns one layer back.
-                    // Insert NOP (no operation) layer;
-                    ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
-                }
+    const auto layer_selector = tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> size_t {
+            // Pressure equalizer need insert empty input. Because it returns one layer back.
+            if (layer_to_print_idx == layers_to_print.size() + (m_pressure_equalizer ? 1 : 0))
+                fc.stop();
+            return layer_to_print_idx ++;
+        });
+    // Build the layer data, which does not depend on the state of the G-code generator, for several layers ahead in parallel.
+    const auto layer_preparer = tbb::make_filter<size_t, PreparedLayer>(slic3r_tbb_filtermode::parallel,
+        [&layers_to_print, reduce_crossing_wall = m_config.reduce_crossing_wall.value](size_t idx) -> PreparedLayer {
+            return idx < layers_to_print.size() ? prepare_layer({ layers_to_print[idx] }, idx, reduce_crossing_wall) : PreparedLayer{ idx };
+        });
+    const auto generator = tbb::make_filter<PreparedLayer, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &layers_to_print, single_object_idx, prime_extruder](PreparedLayer prepared_layer) -> LayerResult {
+            const size_t idx = prepared_layer.layer_to_print_idx;
+            if (idx >= layers_to_print.size()) {
+                // Insert NOP (no operation) layer;
+                return LayerResult::make_nop_layer_result();
             } else {
-                LayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
-                print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(layer_to_print_idx)));
+                LayerToPrint &layer = layers_to_print[idx];
+                print.set_status(80, Slic3r::format(_(L("Generating G-code: layer %1%")), std::to_string(idx + 1)));
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
-                return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, tool_ordering.get_most_used_extruder(), single_object_idx, prime_extruder);
+                return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, tool_ordering.get_most_used_extruder(), single_object_idx, prime_extruder, &prepared_layer);
             }
         });
     if (m_spiral_vase) {
@@ -3716,13 +3774,13 @@ void GCode::process_layers(
 
     // The pipeline elements are joined using const references, thus no copying is performed.
     if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
+        tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & spiral_mode & pressure_equalizer & cooling & fan_mover & output);
     else if (m_spiral_vase)
-    	tbb::parallel_pipeline(12, generator & spiral_mode & cooling & fan_mover & output);
+    	tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & spiral_mode & cooling & fan_mover & output);
     else if	(m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
+        tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & pressure_equalizer & cooling & fan_mover & pa_processor_filter & output);
     else
-    	tbb::parallel_pipeline(12, generator & cooling & fan_mover & pa_processor_filter & output);
+    	tbb::parallel_pipeline(12, layer_selector & layer_preparer & generator & cooling & fan_mover & pa_processor_filter & output);
 }
 
 std::string GCode::placeholder_parser_process(const std::string &name, const std::string &templ, unsigned int current_filament_id, const DynamicConfig *config_override)
@@ -4331,7 +4389,9 @@ LayerResult GCode::process_layer(
     // Otherwise print a single copy of a single object.
     const size_t                     		 single_object_instance_idx,
     // BBS
-    const bool                               prime_extruder)
+    const bool                               prime_extruder,
+    // Layer data built ahead of time by prepare_layer(), if nullptr it is built here.
+    PreparedLayer                           *prepared_layer)
 {
     assert(! layers.empty());
     // Either printing all copies of all objects, or just a single copy of a single object.
@@ -4633,18 +4693,15 @@ LayerResult GCode::process_layer(
         return next_extruder;
     };
     
-    for (const auto &layer_to_print : layers) {
-        if (layer_to_print.object_layer) {
-            const auto& regions = layer_to_print.object_layer->regions();
-            const bool  enable_overhang_speed = std::any_of(regions.begin(), regions.end(), [](const LayerRegion* r) {
-                return r->has_extrusions() && r->region().config().enable_overhang_speed;
-            });
-            if (enable_overhang_speed) {
-                m_extrusion_quality_estimator.prepare_for_new_layer(layer_to_print.original_object,
-                                                                    layer_to_print.object_layer);
-            }
-        }
+    PreparedLayer prepared_here;
+    if (prepared_layer == nullptr) {
+        prepared_here  = prepare_layer(layers, 0, m_config.reduce_crossing_wall);
+        prepared_layer = &prepared_here;
     }
+    assert(prepared_layer->travel_data.size() == layers.size() && prepared_layer->quality_data.size() == layers.size());
+    for (size_t i = 0; i < layers.size(); ++ i)
+        if (std::optional<ExtrusionQualityEstimator::LayerData> &quality_data = prepared_layer->quality_data[i]; quality_data)
+            m_extrusion_quality_estimator.prepare_for_new_layer(layers[i].original_object, std::move(*quality_data));
 
     // Group extrusions by an extruder, then by an object, an island and a region.
     std::map<unsigned int, std::vector<ObjectByExtruder>> by_extruder;
@@ -5126,7 +5183,7 @@ LayerResult GCode::process_layer(
                 m_layer = layer_to_print.layer();
                 m_object_layer_over_raft = object_layer_over_raft;
                 if (m_config.reduce_crossing_wall)
-                    m_avoid_crossing_perimeters.init_layer(*m_layer);
+                    m_avoid_crossing_perimeters.init_layer(prepared_layer->travel_data[instance_to_print.layer_id]);
 
                 if (this->config().gcode_label_objects) {
                     gcode += std::string("; printing object ") + instance_to_print.print_object.model_object()->name +
@@ -5802,7 +5859,7 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, std::string description, dou
         //Point pt = ((nd * nd >= l2) ? (p1+v*0.4): (p1 + 0.2 * v * (nd / sqrt(l2)))).cast<coord_t>();
         pt.rotate(angle, paths.front().polyline.points.front());
         // generate the travel move
-        gcode += m_writer.extrude_to_xy(this->point_to_gcode(pt), 0,"move inwards before travel",true);
+        m_writer.extrude_to_xy(gcode, this->point_to_gcode(pt), 0,"move inwards before travel",true);
     }
 
     return gcode;
@@ -6111,6 +6168,8 @@ double GCode::calc_max_volumetric_speed(const double layer_height, const double
 std::string GCode::_extrude(const ExtrusionPath &path, std::string description, double speed)
 {
     std::string gcode;
+    // Roughly one "G1 X Y E" line of about 32 characters per point, the moves are appended into gcode in place.
+    gcode.reserve(path.polyline.points.size() * 32);
 
     if (is_bridge(path.role()))
         description += " (bridge)";
@@ -6683,7 +6742,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             // ORCA: End of adaptive PA code segment
         }
         
-        gcode += m_writer.set_speed(F, "", comment);
+        m_writer.set_speed(gcode, F, "", comment);
         {
             if (m_enable_cooling_markers) {
                 if (enable_overhang_bridge_fan) {
@@ -6704,8 +6763,10 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             if (!m_config.enable_arc_fitting || path.polyline.fitting_result.empty() || m_config.spiral_mode || sloped != nullptr) {
                 double path_length = 0.;
                 double total_length = sloped == nullptr ? 0. : path.polyline.length() * SCALING_FACTOR;
+                // Reused for all segments, so that its buffer is allocated once per path.
+                std::string tempDescription;
                 for (const Line& line : path.polyline.lines()) {
-                    std::string tempDescription = description;
+                    tempDescription = description;
                     const double line_length = line.length() * SCALING_FACTOR;
                     if (line_length < EPSILON)
                         continue;
@@ -6721,26 +6782,27 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                     }
                     if (sloped == nullptr) {
                         // Normal extrusion
-                        gcode += m_writer.extrude_to_xy(
+                        m_writer.extrude_to_xy(gcode,
                             this->point_to_gcode(line.b),
                             dE,
-                            GCodeWriter::full_gcode_comment ? tempDescription : "", path.is_force_no_extrusion());
+                            tempDescription, path.is_force_no_extrusion());
                     } else {
                         // Sloped extrusion
                         const auto [z_ratio, e_ratio] = sloped->interpolate(path_length / total_length);
                         Vec2d dest2d = this->point_to_gcode(line.b);
                         Vec3d dest3d(dest2d(0), dest2d(1), get_sloped_z(z_ratio));
-                        gcode += m_writer.extrude_to_xyz(
+                        m_writer.extrude_to_xyz(gcode,
                             dest3d,
                             dE * e_ratio,
-                            GCodeWriter::full_gcode_comment ? tempDescription : "", path.is_force_no_extrusion());
+                            tempDescription, path.is_force_no_extrusion());
                     }
                 }
             } else {
                 // BBS: start to generate gcode from arc fitting data which includes line and arc
                 const std::vector<PathFittingData>& fitting_result = path.polyline.fitting_result;
+                std::string tempDescription;
                 for (size_t fitting_index = 0; fitting_index < fitting_result.size(); fitting_index++) {
-                    std::string tempDescription = description;
+                    tempDescription = description;
                     switch (fitting_result[fitting_index].path_type) {
                     case EMovePathType::Linear_move: {
                         size_t start_index = fitting_result[fitting_index].start_point_index;
@@ -6760,10 +6822,10 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                                     tempDescription += Slic3r::format(" | Old Flow Value: %0.5f Length: %0.5f",oldE, line_length);
                                 }
                             }
-                            gcode += m_writer.extrude_to_xy(
+                            m_writer.extrude_to_xy(gcode,
                                 this->point_to_gcode(line.b),
                                 dE,
-                                GCodeWriter::full_gcode_comment ? tempDescription : "", path.is_force_no_extrusion());
+                                tempDescription, path.is_force_no_extrusion());
                         }
                         break;
                     }
@@ -6783,12 +6845,12 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                                 tempDescription += Slic3r::format(" | Old Flow Value: %0.5f Length: %0.5f",oldE, arc_length);
                             }
                         }
-                        gcode += m_writer.extrude_arc_to_xy(
+                        m_writer.extrude_arc_to_xy(gcode,
                             this->point_to_gcode(arc.end_point),
                             center_offset,
                             dE,
                             arc.direction == ArcDirection::Arc_Dir_CCW,
-                            GCodeWriter::full_gcode_comment ? tempDescription : "", path.is_force_no_extrusion());
+                            tempDescription, path.is_force_no_extrusion());
                         break;
                     }
                     default:
@@ -6811,7 +6873,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             Polyline l(p);
             total_length = l.length() * SCALING_FACTOR;
         }
-        gcode += m_writer.set_speed(last_set_speed, "", comment);
+        m_writer.set_speed(gcode, last_set_speed, "", comment);
         Vec2d prev = this->point_to_gcode_quantized(new_points[0].p);
         bool pre_fan_enabled = false;
         bool cur_fan_enabled = false;
@@ -6822,8 +6884,9 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             pre_fan_enabled = true;
 
         double path_length = 0.;
+        std::string tempDescription;
         for (size_t i = 1; i < new_points.size(); i++) {
-            std::string tempDescription = description;
+            tempDescription = description;
             const ProcessedPoint &processed_point = new_points[i];
             const ProcessedPoint &pre_processed_point = new_points[i-1];
             Vec2d p = this->point_to_gcode_quantized(processed_point.p);
@@ -6893,10 +6956,10 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             // Ignore small speed variations - emit speed change if the delta between current and new is greater than 60mm/min / 1mm/sec
             // Reset speed to F if delta to F is less than 1mm/sec
             if ((std::abs(last_set_speed - new_speed) > 60)) {
-                gcode += m_writer.set_speed(new_speed, "", comment);
+                m_writer.set_speed(gcode, new_speed, "", comment);
                 last_set_speed = new_speed;
             } else if ((std::abs(F - new_speed) <= 60)) {
-                gcode += m_writer.set_speed(F, "", comment);
+                m_writer.set_speed(gcode, F, "", comment);
                 last_set_speed = F;
             }
             auto dE = e_per_mm * line_length;
@@ -6910,12 +6973,12 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             }
             if (sloped == nullptr) {
                 // Normal extrusion
-                gcode += m_writer.extrude_to_xy(p, dE, GCodeWriter::full_gcode_comment ? tempDescription : "");
+                m_writer.extrude_to_xy(gcode, p, dE, tempDescription);
             } else {
                 // Sloped extrusion
                 const auto [z_ratio, e_ratio] = sloped->interpolate(path_length / total_length);
                 Vec3d dest3d(p(0), p(1), get_sloped_z(z_ratio));
-                gcode += m_writer.extrude_to_xyz(dest3d, dE * e_ratio, GCodeWriter::full_gcode_comment ? tempDescription : "");
+                m_writer.extrude_to_xyz(gcode, dest3d, dE * e_ratio, tempDescription);
             }
 
             prev = p;
@@ -7122,7 +7185,7 @@ std::string GCode::travel_to(const Point& point, ExtrusionRole role, std::string
         if (false/*m_spiral_vase*/) {
             // No lazy z lift for spiral vase mode
             for (size_t i = 1; i < travel.size(); ++i) {
-                gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), comment);
+                m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), comment);
             }
         } else {
             if (travel.size() == 2) {
@@ -7148,7 +7211,7 @@ std::string GCode::travel_to(const Point& point, ExtrusionRole role, std::string
                         gcode += m_writer.travel_to_xyz(dest3d, comment);
                     } else {
                         // For all points in between, no z change
-                        gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), comment);
+                        m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), comment);
                     }
                 }
             }
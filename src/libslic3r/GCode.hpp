@@ -31,6 +31,7 @@
 
 #include <memory>
 #include <map>
+#include <optional>
 #include <set>
 #include <string>
 #include <cfloat>
@@ -214,6 +215,8 @@ public:
     // throws CanceledException through print->throw_if_canceled().
     void            do_export(Print* print, const char* path, GCodeProcessorResult* result = nullptr, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
     void            export_layer_filaments(GCodeProcessorResult* result);
+    // Whether do_export() released the extrusions of some layers, see Print::release_extrusions_on_export().
+    bool            released_extrusions() const { return m_released_extrusions; }
     //BBS: set offset for gcode writer
     void set_gcode_offset(double x, double y) { m_writer.set_xy_offset(x, y); m_processor.set_xy_offset(x, y);}
 
@@ -341,6 +344,20 @@ private:
         const Layer& layer,
         unsigned int extruder_id);
 
+    // Data of the layers printed at a single print_z, which depends on the layer geometry only and not on the state
+    // of the G-code generator. It is built for the following layers by a parallel stage of the pipeline,
+    // while the serial process_layer() generates G-code of the current layer.
+    struct PreparedLayer
+    {
+        // Index into the layers to print.
+        size_t                                                                 layer_to_print_idx { 0 };
+        // Indexed by LayerToPrint, nullptr if reduce_crossing_wall is disabled.
+        std::vector<std::shared_ptr<const AvoidCrossingPerimeters::LayerData>> travel_data;
+        // Indexed by LayerToPrint, empty if the overhang speed is disabled for all regions of the layer.
+        std::vector<std::optional<ExtrusionQualityEstimator::LayerData>>       quality_data;
+    };
+    static PreparedLayer prepare_layer(const std::vector<LayerToPrint> &layers, size_t layer_to_print_idx, bool reduce_crossing_wall);
+
     LayerResult process_layer(
         const Print                     &print,
         // Set of object & print layers of the same PrintObject and with the same print_z.
@@ -355,7 +372,9 @@ private:
         // Otherwise print a single copy of a single object.
         const size_t                     single_object_idx = size_t(-1),
         // BBS
-        const bool                       prime_extruder = false);
+        const bool                       prime_extruder = false,
+        // Layer data built ahead of time by prepare_layer(), if nullptr it is built by process_layer() itself.
+        PreparedLayer                   *prepared_layer = nullptr);
     // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
     // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
     // and export G-code into file.
@@ -628,6 +647,7 @@ private:
     unsigned int m_toolchange_count;
     coordf_t m_nominal_z;
     bool m_need_change_layer_lift_z = false;
+    bool m_released_extrusions = false;
     int m_start_gcode_filament = -1;
     std::string m_filament_instances_code;
 
@@ -5,6 +5,8 @@
 #include "../ExPolygon.hpp"
 #include "../EdgeGrid.hpp"
 
+#include <memory>
+
 namespace Slic3r {
 
 // Forward declarations.
@@ -24,7 +26,20 @@ public:
     bool        disabled_once() const   { return m_disabled_once; }
     void        reset_once_modifiers()  { m_use_external_mp_once = false; m_disabled_once = false; }
 
-    void        init_layer(const Layer &layer);
+    // Data of a layer used by travel_to(), which depends on the layer geometry only.
+    // It may be prepared for the following layers in parallel with the G-code generation of the current layer
+    // and it is shared by all instances of an object printed at the same layer.
+    struct LayerData {
+        // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
+        ExPolygons               lslices_offset;
+        std::vector<BoundingBox> lslices_offset_bboxes;
+        // Used for detection of line or polyline is inside of any polygon.
+        EdgeGrid::Grid           grid_lslice;
+    };
+    static std::shared_ptr<const LayerData> prepare_layer(const Layer &layer);
+
+    void        init_layer(const Layer &layer) { this->init_layer(prepare_layer(layer)); }
+    void        init_layer(std::shared_ptr<const LayerData> layer_data);
 
     Polyline    travel_to(const GCode& gcodegen, const Point& point)
     {
@@ -59,11 +74,8 @@ private:
     // we enable it by default for the first travel move in print
     bool           m_disabled_once { true };
 
-    // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
-    ExPolygons               m_lslices_offset;
-    std::vector<BoundingBox> m_lslices_offset_bboxes;
-    // Used for detection of line or polyline is inside of any polygon.
-    EdgeGrid::Grid m_grid_lslice;
+    // Lslices of the current layer, see LayerData.
+    std::shared_ptr<const LayerData> m_layer_data;
     // Store all needed data for travels inside object
     Boundary m_internal;
     // Store all needed data for travels outside object
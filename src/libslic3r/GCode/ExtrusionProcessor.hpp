@@ -299,14 +299,31 @@ class ExtrusionQualityEstimator
 public:
     void set_current_object(const PrintObject *object) { current_object = object; }
 
+    // AABB trees of a single layer, they depend on the layer geometry only, thus they may be built ahead of time.
+    struct LayerData
+    {
+        AABBTreeLines::LinesDistancer<Linef>      layer_boundaries;
+        AABBTreeLines::LinesDistancer<CurledLine> curled_extrusions;
+    };
+
+    static LayerData prepare_layer(const Layer &layer)
+    {
+        return { AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer.lslices)},
+                 AABBTreeLines::LinesDistancer<CurledLine>{layer.curled_lines} };
+    }
+
     void prepare_for_new_layer(const PrintObject * obj, const Layer *layer)
     {
         if (layer == nullptr) return;
-        const PrintObject *object = obj;
-        prev_layer_boundaries[object] = next_layer_boundaries[object];
-        next_layer_boundaries[object] = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer->lslices)};
-        prev_curled_extrusions[object] = next_curled_extrusions[object];
-        next_curled_extrusions[object] = AABBTreeLines::LinesDistancer<CurledLine>{layer->curled_lines};
+        this->prepare_for_new_layer(obj, prepare_layer(*layer));
+    }
+
+    void prepare_for_new_layer(const PrintObject *object, LayerData &&layer_data)
+    {
+        prev_layer_boundaries[object] = std::move(next_layer_boundaries[object]);
+        next_layer_boundaries[object] = std::move(layer_data.layer_boundaries);
+        prev_curled_extrusions[object] = std::move(next_curled_extrusions[object]);
+        next_curled_extrusions[object] = std::move(layer_data.curled_extrusions);
     }
 
     std::vector<ProcessedPoint> estimate_extrusion_quality(const ExtrusionPath                &path,
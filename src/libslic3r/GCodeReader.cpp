@@ -8,12 +8,36 @@
 #include <iostream>
 #include <iomanip>
 #include "Utils.hpp"
+#include "Thread.hpp"
 
 #include "LocalesUtils.hpp"
 
 #include <Shiny/Shiny.h>
 #include <fast_float/fast_float.h>
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 void GCodeReader::apply_config(const GCodeConfig &config)
@@ -31,7 +55,21 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
     PROFILE_FUNC();
 
     assert(is_decimal_separator_point());
-    
+    const char *c = tokenize_line(ptr, end, gline, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return c;
+}
+
+const char* GCodeReader::tokenize_line(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
+{
+    // fast_float::from_chars() does not depend on the locale, thus the lines may be tokenized by the worker threads,
+    // which do not share the numeric locale of the thread calling parse_line().
     // command and args
     const char *c = ptr;
     {
@@ -67,7 +105,9 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
             if (axis != NUM_AXES_WITH_UNKNOWN) {
                 // Try to parse the numeric value.
                 double v;
-                auto [pend, ec] = fast_float::from_chars(++ c, end, v);
+                const char *pend = parse_decimal(++ c, end, v);
+                if (pend == nullptr)
+                    pend = fast_float::from_chars(c, end, v).ptr;
                 if (pend != c && is_end_of_word(*pend)) {
                     // The axis value has been parsed correctly.
                     if (axis != UNKNOWN_AXIS)
@@ -82,9 +122,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
@@ -101,9 +138,6 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
 	if (*c == '\n')
 		++ c;
 
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
@@ -215,6 +249,171 @@ bool GCodeReader::parse_file(const std::string &file, callback_t callback, std::
     return ret;
 }
 
+bool GCodeReader::parse_file_parallel(const std::string &filename, callback_t callback, std::vector<size_t> &lines_ends)
+{
+    lines_ends.clear();
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  before parse_file_parallel %1%") % filename.c_str();
+
+    boost::system::error_code ec;
+    uintmax_t file_size = boost::filesystem::file_size(filename, ec);
+    if (ec)
+        return false;
+    m_parsing = true;
+    if (file_size == 0)
+        return true;
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(filename);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed to map " << filename << ": " << ex.what();
+        return false;
+    }
+    if (! file.is_open())
+        return false;
+
+    // Lines of a chunk of the file, tokenized ahead of time.
+    struct Chunk {
+        std::vector<GCodeLine> lines;
+        std::vector<size_t>    lines_ends;
+    };
+    // Chunks of roughly 4MB split at line ends, so that the pipeline keeps a limited number of tokenized lines in memory.
+    static constexpr const size_t chunk_size = 4 * 1024 * 1024;
+    const char       *data      = file.data();
+    const char       *data_end  = data + file.size();
+    const char       *chunk_ptr = data;
+    std::atomic<bool> stop { false };
+
+    auto tokenize_chunk = [data, data_end](std::pair<const char*, const char*> range) {
+        Chunk chunk;
+        chunk.lines.reserve((range.second - range.first) / 24);
+        std::string last_line;
+        for (const char *it = range.first; it != range.second;) {
+            // Find end of line, the end of the file is an end of line as well.
+            const char *it_end = it;
+            for (; it_end != range.second && *it_end != '\r' && *it_end != '\n'; ++ it_end) ;
+            const char *begin = it;
+            const char *end   = it_end;
+            if (end == data_end) {
+                // The last line is not terminated by a new line, the tokenizer needs a terminating character.
+                last_line.assign(begin, end);
+                begin = last_line.c_str();
+                end   = begin + last_line.size();
+            }
+            begin = skip_whitespaces(begin);
+            if (std::toupper(*begin) == 'N')
+                begin = skip_word(begin);
+            begin = skip_whitespaces(begin);
+            std::pair<const char*, const char*> command;
+            tokenize_line(begin, end, chunk.lines.emplace_back(), command);
+            // Skip EOL.
+            it = it_end;
+            if (it != range.second && *it == '\r')
+                ++ it;
+            if (it != range.second && *it == '\n') {
+                chunk.lines_ends.emplace_back(size_t(it - data) + 1);
+                ++ it;
+            }
+        }
+        return chunk;
+    };
+
+    // The pipeline runs on a helper thread and hands the tokenized chunks over in order through a short queue, the callback
+    // is called from the calling thread. Thus the callback sees the locale and the state of the calling thread.
+    static constexpr const size_t max_queued_chunks = 2;
+    std::mutex              queue_mutex;
+    std::condition_variable queue_condition;
+    std::deque<Chunk>       queue;
+    bool                    tokenized_all { false };
+    std::exception_ptr      tokenize_exception;
+
+    boost::thread tokenizer = create_thread([&]() {
+        try {
+            tbb::parallel_pipeline(std::max<size_t>(2, 2 * std::thread::hardware_concurrency()),
+                tbb::make_filter<void, std::pair<const char*, const char*>>(slic3r_tbb_filtermode::serial_in_order,
+                    [&chunk_ptr, data_end, &stop](tbb::flow_control &fc) -> std::pair<const char*, const char*> {
+                        if (chunk_ptr == data_end || stop) {
+                            fc.stop();
+                            return {};
+                        }
+                        const char *begin = chunk_ptr;
+                        const char *end   = data_end - begin > chunk_size ? begin + chunk_size : data_end;
+                        // Extend the chunk up to the end of line, "\r\n" is never split.
+                        end = std::find(end, data_end, '\n');
+                        if (end != data_end)
+                            ++ end;
+                        chunk_ptr = end;
+                        return { begin, end };
+                    }) &
+                tbb::make_filter<std::pair<const char*, const char*>, Chunk>(slic3r_tbb_filtermode::parallel, tokenize_chunk) &
+                tbb::make_filter<Chunk, void>(slic3r_tbb_filtermode::serial_in_order,
+                    [&queue_mutex, &queue_condition, &queue, &stop](Chunk chunk) {
+                        std::unique_lock<std::mutex> lock(queue_mutex);
+                        queue_condition.wait(lock, [&queue, &stop]() { return queue.size() < max_queued_chunks || stop; });
+                        if (! stop)
+                            queue.emplace_back(std::move(chunk));
+                        lock.unlock();
+                        queue_condition.notify_all();
+                    }));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            tokenize_exception = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            tokenized_all = true;
+        }
+        queue_condition.notify_all();
+    });
+    auto stop_tokenizer = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        queue_condition.notify_all();
+        tokenizer.join();
+    };
+
+    try {
+        for (;;) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_condition.wait(lock, [&queue, &tokenized_all]() { return ! queue.empty() || tokenized_all; });
+                if (queue.empty())
+                    break;
+                chunk = std::move(queue.front());
+                queue.pop_front();
+            }
+            queue_condition.notify_all();
+            for (GCodeLine &gline : chunk.lines) {
+                if (gline.has(E) && m_config.use_relative_e_distances)
+                    m_position[E] = 0;
+                callback(*this, gline);
+                std::pair<const char*, const char*> command;
+                command.first  = skip_whitespaces(gline.raw().c_str());
+                command.second = skip_word(command.first);
+                update_coordinates(gline, command);
+                if (! m_parsing)
+                    // The callback wishes to exit.
+                    break;
+            }
+            if (! m_parsing)
+                break;
+            append(lines_ends, std::move(chunk.lines_ends));
+        }
+    } catch (...) {
+        // Cancelled by the callback.
+        stop_tokenizer();
+        throw;
+    }
+    stop_tokenizer();
+    if (tokenize_exception)
+        std::rethrow_exception(tokenize_exception);
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(":  finished parse_file_parallel %1%") % filename.c_str();
+    return true;
+}
+
 bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_t line_callback)
 {
     return this->parse_file_raw_internal(filename,
@@ -244,6 +443,41 @@ const char* GCodeReader::axis_pos(const char *raw_str, char axis)
     return nullptr;
 }
 
+const char* GCodeReader::parse_decimal(const char *c, const char *end, double &v)
+{
+    // Powers of ten up to 10^15 are exact in double, integers up to 15 digits are exact in double as well,
+    // thus the single division below is correctly rounded, giving the same result as fast_float or strtod.
+    static constexpr const std::array<double, 16> pow_10 { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+    static constexpr const int max_digits = 15;
+    const char *p = c;
+    bool negative = p != end && *p == '-';
+    if (negative)
+        ++ p;
+    uint64_t mantissa   = 0;
+    int      num_digits = 0;
+    int      num_fraction_digits = -1;
+    for (; p != end; ++ p) {
+        if (*p >= '0' && *p <= '9') {
+            if (++ num_digits > max_digits)
+                return nullptr;
+            mantissa = mantissa * 10 + uint64_t(*p - '0');
+            if (num_fraction_digits >= 0)
+                ++ num_fraction_digits;
+        } else if (*p == '.' && num_fraction_digits < 0)
+            num_fraction_digits = 0;
+        else
+            break;
+    }
+    if (num_digits == 0 || (p != end && ! is_end_of_word(*p)))
+        return nullptr;
+    v = double(mantissa);
+    if (num_fraction_digits > 0)
+        v /= pow_10[num_fraction_digits];
+    if (negative)
+        v = -v;
+    return p;
+}
+
 bool GCodeReader::GCodeLine::has(char axis) const
 {
     const char *c = m_raw.c_str();
@@ -279,7 +513,9 @@ bool GCodeReader::GCodeLine::has_value(std::string_view axis_pos, float &value)
         // Try to parse the numeric value.
         double v = 0.;
         const char *end = axis_pos.data() + axis_pos.size();
-        auto [pend, ec] = fast_float::from_chars(++ c, end, v);
+        const char *pend = parse_decimal(++ c, end, v);
+        if (pend == nullptr)
+            pend = fast_float::from_chars(c, end, v).ptr;
         if (pend != c && is_end_of_word(*pend)) {
             // The axis value has been parsed correctly.
             value = float(v);
@@ -306,8 +542,13 @@ bool GCodeReader::GCodeLine::has_value(char axis, float &value) const
         // Check the name of the axis.
         if (*c == axis) {
             // Try to parse the numeric value.
-            char   *pend = nullptr;
-            double  v = strtod(++ c, &pend);
+            double      v;
+            const char *pend = parse_decimal(++ c, m_raw.data() + m_raw.size(), v);
+            if (pend == nullptr) {
+                char *pend_strtod = nullptr;
+                v    = strtod(c, &pend_strtod);
+                pend = pend_strtod;
+            }
             if (pend != nullptr && is_end_of_word(*pend)) {
                 // The axis value has been parsed correctly.
                 value = float(v);
@@ -144,6 +144,10 @@ public:
     // Collect positions of line ends in the binary G-code to be used by the G-code viewer when memory mapping and displaying section of G-code
     // as an overlay in the 3D scene.
     bool parse_file(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
+    // Same as above, but the file is memory mapped and split into chunks at line boundaries, the lines of the chunks are tokenized
+    // ahead of time by a TBB pipeline running on a helper thread, while the callback is called for all lines in order
+    // from the calling thread, which drains the tokenized chunks from a short queue.
+    bool parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
     // Just read the G-code file line by line, calls callback (const char *begin, const char *end). Returns false if reading the file failed.
     bool parse_file_raw(const std::string &file, raw_line_callback_t callback);
 
@@ -178,6 +182,8 @@ private:
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Parse the axes of a single line, independent of the state of the reader, thus it may be called from multiple threads.
+    static const char* tokenize_line(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
@@ -195,6 +201,10 @@ private:
         return c;
     }
     static const char*  axis_pos(const char *raw_str, char axis);
+    // Fast path for parsing a plain decimal number of at most 15 digits, which covers the numbers emitted by slicers.
+    // Returns the end of the number if it was parsed and it is followed by an end of word, nullptr if the number has
+    // to be parsed by a general parser (exponent, too many digits, leading plus sign, not followed by an end of word).
+    static const char*  parse_decimal(const char *c, const char *end, double &v);
 
     GCodeConfig m_config;
     float       m_position[NUM_AXES];
@@ -11,6 +11,8 @@
 #include "libnest2d/tools/benchmark.h"
 #include "Execution/ExecutionTBB.hpp"
 
+#include <atomic>
+
 namespace Slic3r {
 
 template<class ExPolicy>
@@ -95,6 +97,55 @@ private:
     size_t                       m_seed { 0 };
 };
 
+// Label the faces connected by their shared edges with the index of their patch, the patches are numbered by their lowest face index,
+// that is in the same order the NeighborVisitor discovers them. Returns the number of patches.
+// The patches are found by a lock-free union-find running in parallel over the faces: a root is always linked below a root
+// with a lower face index, thus the links never form a cycle and each patch ends up rooted at its lowest face.
+template<class NeighborIndex>
+size_t label_face_patches(const NeighborIndex &neighbor_index, size_t num_faces, std::vector<uint32_t> &face_patch)
+{
+    std::vector<std::atomic<uint32_t>> parent(num_faces);
+    execution::for_each(ex_tbb, size_t(0), num_faces, [&parent](size_t face_idx) {
+        parent[face_idx].store(uint32_t(face_idx), std::memory_order_relaxed);
+    }, 1024);
+    auto find_root = [&parent](uint32_t i) {
+        for (;;) {
+            uint32_t p = parent[i].load(std::memory_order_relaxed);
+            if (p == i)
+                return i;
+            // Path halving.
+            uint32_t gp = parent[p].load(std::memory_order_relaxed);
+            if (gp != p)
+                parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+        }
+    };
+    execution::for_each(ex_tbb, size_t(0), num_faces, [&neighbor_index, &parent, &find_root](size_t face_idx) {
+        for (auto neighbor_idx : neighbor_index[face_idx])
+            if (neighbor_idx > int(face_idx))
+                for (uint32_t a = uint32_t(face_idx), b = uint32_t(neighbor_idx);;) {
+                    a = find_root(a);
+                    b = find_root(b);
+                    if (a == b)
+                        break;
+                    if (a < b)
+                        std::swap(a, b);
+                    // Link the root with the higher index below the other one.
+                    if (parent[a].compare_exchange_strong(a, b, std::memory_order_relaxed))
+                        break;
+                }
+    }, 1024);
+    face_patch.assign(num_faces, 0);
+    execution::for_each(ex_tbb, size_t(0), num_faces, [&face_patch, &find_root](size_t face_idx) {
+        face_patch[face_idx] = find_root(uint32_t(face_idx));
+    }, 1024);
+    // Number the roots in the order of their face indices, each root precedes the rest of its patch.
+    uint32_t num_patches = 0;
+    for (size_t face_idx = 0; face_idx < num_faces; ++ face_idx)
+        face_patch[face_idx] = face_patch[face_idx] == face_idx ? num_patches ++ : face_patch[face_patch[face_idx]];
+    return num_patches;
+}
+
 } // namespace meshsplit_detail
 
 // Funky wrapper for timinig of its_split() using various neighbor index creating methods, see sandboxes/its_neighbor_index/main.cpp
@@ -130,6 +181,8 @@ struct SplitOutputFn {
 };
 
 // Splits a mesh into multiple meshes when possible.
+// The faces are assigned to the parts in parallel, then the parts are assembled in parallel, each with the faces
+// in the order of their indices in the source mesh and with the vertices in the order of their indices in the source mesh.
 template<class Its, class OutputIt>
 void its_split(const Its &m, OutputIt out_it)
 {
@@ -137,45 +190,49 @@ void its_split(const Its &m, OutputIt out_it)
 
     const indexed_triangle_set &its = ItsWithNeighborsIndex_<Its>::get_its(m);
 
-    struct VertexConv {
-        size_t part_id      = std::numeric_limits<size_t>::max();
-        size_t vertex_image;
-    };
-    std::vector<VertexConv> vidx_conv(its.vertices.size());
-
-    meshsplit_detail::NeighborVisitor visitor(its, meshsplit_detail::ItsWithNeighborsIndex_<Its>::get_index(m));
-
-    std::vector<size_t> facets;
-    for (size_t part_id = 0;; ++part_id) {
-        // Collect all faces of the next patch.
-        facets.clear();
-        visitor.visit([&facets](size_t idx) { facets.emplace_back(idx); return true; });
-        if (facets.empty())
-            break;
-
-        // Create a new mesh for the part that was just split off.
-        indexed_triangle_set mesh;
-        mesh.indices.reserve(facets.size());
-        mesh.vertices.reserve(std::min(facets.size() * 3, its.vertices.size()));
-
-        // Assign the facets to the new mesh.
-        for (size_t face_id : facets) {
-            const auto &face = its.indices[face_id];
-            Vec3i32       new_face;
-            for (size_t v = 0; v < 3; ++v) {
-                auto vi = face(v);
-
-                if (vidx_conv[vi].part_id != part_id) {
-                    vidx_conv[vi] = {part_id, mesh.vertices.size()};
-                    mesh.vertices.emplace_back(its.vertices[size_t(vi)]);
-                }
+    std::vector<uint32_t> face_patch;
+    const size_t          num_parts = label_face_patches(ItsWithNeighborsIndex_<Its>::get_index(m), its.indices.size(), face_patch);
 
-                new_face(v) = vidx_conv[vi].vertex_image;
-            }
+    // Faces of each part sorted by the face index, stored in a compressed row format.
+    std::vector<size_t> part_faces_begin(num_parts + 1, 0);
+    for (uint32_t part_id : face_patch)
+        ++ part_faces_begin[part_id + 1];
+    for (size_t part_id = 0; part_id < num_parts; ++ part_id)
+        part_faces_begin[part_id + 1] += part_faces_begin[part_id];
+    std::vector<uint32_t> part_faces(its.indices.size());
+    {
+        std::vector<size_t> part_faces_end(part_faces_begin.begin(), part_faces_begin.end() - 1);
+        for (size_t face_id = 0; face_id < face_patch.size(); ++ face_id)
+            part_faces[part_faces_end[face_patch[face_id]] ++] = uint32_t(face_id);
+    }
 
+    std::vector<indexed_triangle_set> parts(num_parts);
+    execution::for_each(ex_tbb, size_t(0), num_parts, [&its, &parts, &part_faces, &part_faces_begin](size_t part_id) {
+        indexed_triangle_set &mesh  = parts[part_id];
+        const size_t          begin = part_faces_begin[part_id];
+        const size_t          end   = part_faces_begin[part_id + 1];
+        // Vertices of the part sorted by their index in the source mesh.
+        std::vector<int> vertices;
+        vertices.reserve(3 * (end - begin));
+        for (size_t i = begin; i < end; ++ i) {
+            const stl_triangle_vertex_indices &face = its.indices[part_faces[i]];
+            vertices.insert(vertices.end(), face.data(), face.data() + 3);
+        }
+        sort_remove_duplicates(vertices);
+        mesh.vertices.reserve(vertices.size());
+        for (int vi : vertices)
+            mesh.vertices.emplace_back(its.vertices[size_t(vi)]);
+        mesh.indices.reserve(end - begin);
+        for (size_t i = begin; i < end; ++ i) {
+            const stl_triangle_vertex_indices &face = its.indices[part_faces[i]];
+            Vec3i32 new_face;
+            for (size_t v = 0; v < 3; ++ v)
+                new_face(v) = int(std::lower_bound(vertices.begin(), vertices.end(), face(v)) - vertices.begin());
             mesh.indices.emplace_back(new_face);
         }
+    });
 
+    for (indexed_triangle_set &mesh : parts) {
         *out_it = std::move(mesh);
         ++out_it;
     }
@@ -207,17 +264,9 @@ bool its_is_splittable(const Its &m)
 template<class Its>
 size_t its_number_of_patches(const Its &m)
 {
-    meshsplit_detail::NeighborVisitor visitor(meshsplit_detail::ItsWithNeighborsIndex_<Its>::get_its(m), meshsplit_detail::ItsWithNeighborsIndex_<Its>::get_index(m));
-    size_t num_patches = 0;
-    for (;;) {
-        bool has_some = false;
-        // Traverse the 1st patch fully.
-        visitor.visit([&has_some](size_t idx) { has_some = true; return true; });
-        if (! has_some)
-            break;
-        ++ num_patches;
-    }
-    return num_patches;
+    std::vector<uint32_t> face_patch;
+    return meshsplit_detail::label_face_patches(meshsplit_detail::ItsWithNeighborsIndex_<Its>::get_index(m),
+        meshsplit_detail::ItsWithNeighborsIndex_<Its>::get_its(m).indices.size(), face_patch);
 }
 
 template<class ExPolicy>
@@ -1260,6 +1260,17 @@ ModelVolume *ModelObject::add_volume(TriangleMesh &&mesh, ModelVolumeType type /
     return v;
 }
 
+ModelVolume *ModelObject::add_volume(TriangleMesh &&mesh, TriangleMesh &&convex_hull, ModelVolumeType type /*= ModelVolumeType::MODEL_PART*/)
+{
+    ModelVolume* v = new ModelVolume(this, std::move(mesh), std::move(convex_hull), type);
+    this->volumes.push_back(v);
+    v->center_geometry_after_creation();
+    this->invalidate_bounding_box();
+    // BBS: backup
+    Slic3r::save_object_mesh(*this);
+    return v;
+}
+
 ModelVolume* ModelObject::add_volume(const ModelVolume &other, ModelVolumeType type /*= ModelVolumeType::INVALID*/)
 {
     ModelVolume* v = new ModelVolume(this, other);
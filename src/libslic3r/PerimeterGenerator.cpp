@@ -17,6 +17,7 @@
 #include <cassert>
 #include <unordered_set>
 #include <thread>
+#include <tbb/parallel_for.h>
 #include "libslic3r/AABBTreeLines.hpp"
 #include "Print.hpp"
 static const int overhang_sampling_number = 6;
@@ -1056,7 +1057,7 @@ std::tuple<std::vector<ExtrusionPaths>, Polygons> generate_extra_perimeters_over
     return {extra_perims, diff(inset_overhang_area, inset_overhang_area_left_unfilled)};
 }
 
-void PerimeterGenerator::apply_extra_perimeters(ExPolygons &infill_area)
+void PerimeterGenerator::apply_extra_perimeters(ExPolygons &infill_area, ExtrusionEntityCollection &loops, SurfaceCollection &fill_surfaces) const
 {
     if (!m_spiral_vase && this->lower_slices != nullptr && this->config->detect_overhang_wall && this->config->extra_perimeters_on_overhangs &&
         this->config->wall_loops > 0 && this->layer_id > this->object_config->raft_layers) {
@@ -1065,8 +1066,8 @@ void PerimeterGenerator::apply_extra_perimeters(ExPolygons &infill_area)
                                                                                         this->config->wall_loops, this->overhang_flow,
                                                                                         this->m_scaled_resolution, *this->object_config,
                                                                                         *this->print_config);
-        if (!extra_perimeters.empty()) {
-            ExtrusionEntityCollection *this_islands_perimeters = static_cast<ExtrusionEntityCollection *>(this->loops->entities.back());
+        if (!extra_perimeters.empty() && !loops.entities.empty()) {
+            ExtrusionEntityCollection *this_islands_perimeters = static_cast<ExtrusionEntityCollection *>(loops.entities.back());
             ExtrusionEntityCollection  new_perimeters{};
             new_perimeters.no_sort = this_islands_perimeters->no_sort;
             for (const ExtrusionPaths &paths : extra_perimeters) {
@@ -1075,16 +1076,26 @@ void PerimeterGenerator::apply_extra_perimeters(ExPolygons &infill_area)
             new_perimeters.append(this_islands_perimeters->entities);
             this_islands_perimeters->swap(new_perimeters);
 
-            SurfaceCollection orig_surfaces = *this->fill_surfaces;
-            this->fill_surfaces->clear();
+            SurfaceCollection orig_surfaces = std::move(fill_surfaces);
+            fill_surfaces.clear();
             for (const auto &surface : orig_surfaces.surfaces) {
                 auto new_surfaces = diff_ex({surface.expolygon}, filled_area);
-                this->fill_surfaces->append(new_surfaces, surface);
+                fill_surfaces.append(new_surfaces, surface);
             }
         }
     }
 }
 
+void PerimeterGenerator::append_island_outputs(std::vector<IslandOutput> &island_outputs)
+{
+    for (IslandOutput &out : island_outputs) {
+        this->loops->append(std::move(out.loops.entities));
+        this->gap_fill->append(std::move(out.gap_fill.entities));
+        this->fill_surfaces->append(std::move(out.fill_surfaces));
+        append(*this->fill_no_overlap, std::move(out.fill_no_overlap));
+    }
+}
+
 // Reorient loop direction
 static void reorient_perimeters(ExtrusionEntityCollection &entities, bool steep_overhang_contour, bool steep_overhang_hole, bool reverse_internal_only)
 {
@@ -1191,8 +1202,7 @@ void PerimeterGenerator::process_classic()
     for (const Surface &surface : all_surfaces)
         surface_exp.push_back(surface.expolygon);
     std::vector<size_t> surface_order = chain_expolygons(surface_exp);
-    for (size_t order_idx = 0; order_idx < surface_order.size(); order_idx++) {
-        const Surface &surface = all_surfaces[surface_order[order_idx]];
+    auto process_island = [&](const Surface &surface, IslandOutput &out) {
         // detect how many perimeters must be generated for this island
         int loop_number = this->config->wall_loops + surface.extra_perimeters - 1;  // 0-indexed loops
         int sparse_infill_density = this->config->sparse_infill_density.value;
@@ -1539,7 +1549,7 @@ void PerimeterGenerator::process_classic()
             
             // append perimeters for this slice as a collection
             if (! entities.empty())
-                this->loops->append(entities);
+                out.loops.append(entities);
 
         } // for each loop of an island
 
@@ -1593,7 +1603,7 @@ void PerimeterGenerator::process_classic()
                 //FIXME Vojtech: This grows by a rounded extrusion width, not by line spacing,
                 // therefore it may cover the area, but no the volume.
                 last = diff_ex(last, gap_fill.polygons_covered_by_width(10.f));
-                this->gap_fill->append(std::move(gap_fill.entities));
+                out.gap_fill.append(std::move(gap_fill.entities));
 
 			}
         }
@@ -1640,9 +1650,9 @@ void PerimeterGenerator::process_classic()
         if (!top_fills.empty()) {
             infill_exp = union_ex(infill_exp, offset_ex(top_infill_exp, double(top_infill_peri_overlap)));
         }
-        this->fill_surfaces->append(infill_exp, stInternal);
+        out.fill_surfaces.append(infill_exp, stInternal);
 
-        apply_extra_perimeters(infill_exp);
+        apply_extra_perimeters(infill_exp, out.loops, out.fill_surfaces);
 
         // BBS: get the no-overlap infill expolygons
         {
@@ -1658,10 +1668,16 @@ void PerimeterGenerator::process_classic()
                     double(-inset - infill_peri_overlap));
             if (!top_fills.empty())
                 polyWithoutOverlap = union_ex(polyWithoutOverlap, top_infill_exp);
-            this->fill_no_overlap->insert(this->fill_no_overlap->end(), polyWithoutOverlap.begin(), polyWithoutOverlap.end());
+            append(out.fill_no_overlap, std::move(polyWithoutOverlap));
         }
 
-    } // for each island
+    };
+    std::vector<IslandOutput> island_outputs(surface_order.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, surface_order.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t order_idx = range.begin(); order_idx < range.end(); ++ order_idx)
+            process_island(all_surfaces[surface_order[order_idx]], island_outputs[order_idx]);
+    });
+    this->append_island_outputs(island_outputs);
 }
 
 //BBS:
@@ -2104,9 +2120,20 @@ void PerimeterGenerator::process_arachne()
     process_no_bridge(all_surfaces, perimeter_spacing, ext_perimeter_width);
     // BBS: don't simplify too much which influence arc fitting when export gcode if arc_fitting is enabled
     double surface_simplify_resolution = (print_config->enable_arc_fitting && !this->has_fuzzy_skin) ? 0.2 * m_scaled_resolution : m_scaled_resolution;
+    auto generate_wall_tool_paths = [this](const Polygons &outline, coord_t bead_width_0, coord_t bead_width_x, size_t inset_count, coord_t wall_0_inset,
+                                           const Arachne::WallToolPathsParams &params, std::vector<Arachne::VariableWidthLines> &toolpaths, Polygons &inner_contour) {
+        if (this->wall_tool_paths_cache) {
+            this->wall_tool_paths_cache->generate(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, this->layer_height, params, toolpaths, inner_contour);
+        } else {
+            Arachne::WallToolPaths wall_tool_paths(outline, bead_width_0, bead_width_x, inset_count, wall_0_inset, this->layer_height, params);
+            toolpaths     = wall_tool_paths.getToolPaths();
+            inner_contour = wall_tool_paths.getInnerContour();
+        }
+    };
+
     // we need to process each island separately because we might have different
     // extra perimeters for each one
-    for (const Surface& surface : all_surfaces) {
+    auto process_island = [&](const Surface &surface, IslandOutput &out) {
         coord_t bead_width_0 = ext_perimeter_spacing;
         // detect how many perimeters must be generated for this island
         int loop_number = this->config->wall_loops + surface.extra_perimeters - 1; // 0-indexed loops
@@ -2150,10 +2177,10 @@ void PerimeterGenerator::process_arachne()
         Arachne::WallToolPathsParams input_params_tmp = input_params;
         
         Polygons   last_p = to_polygons(last);
-        Arachne::WallToolPaths wallToolPaths(last_p, bead_width_0, perimeter_spacing, coord_t(loop_number + 1),
-                                               wall_0_inset, layer_height, input_params_tmp);
-        std::vector<Arachne::VariableWidthLines>   perimeters = wallToolPaths.getToolPaths();
-        ExPolygons  infill_contour = union_ex(wallToolPaths.getInnerContour());
+        std::vector<Arachne::VariableWidthLines>   perimeters;
+        Polygons    inner_contour;
+        generate_wall_tool_paths(last_p, bead_width_0, perimeter_spacing, coord_t(loop_number + 1), wall_0_inset, input_params_tmp, perimeters, inner_contour);
+        ExPolygons  infill_contour = union_ex(inner_contour);
 
         // Check if there are some remaining perimeters to generate (the number of perimeters
         // is greater than one together with enabled the single perimeter on top surface feature).
@@ -2202,8 +2229,9 @@ void PerimeterGenerator::process_arachne()
                 top_expolygons = intersection_ex(top_expolygons, infill_contour);
 
                 const Polygons not_top_polygons = to_polygons(offset_ex(not_top_expolygons,wall_0_inset));
-                Arachne::WallToolPaths inner_wall_tool_paths(not_top_polygons, perimeter_spacing, perimeter_spacing, coord_t(inner_loop_number + 1), 0, layer_height, input_params_tmp);
-                std::vector<Arachne::VariableWidthLines> inner_perimeters = inner_wall_tool_paths.getToolPaths();
+                std::vector<Arachne::VariableWidthLines> inner_perimeters;
+                Polygons inner_wall_inner_contour;
+                generate_wall_tool_paths(not_top_polygons, perimeter_spacing, perimeter_spacing, coord_t(inner_loop_number + 1), 0, input_params_tmp, inner_perimeters, inner_wall_inner_contour);
 
                 // Recalculate indexes of inner perimeters before merging them.
                 if (!perimeters.empty()) {
@@ -2216,13 +2244,12 @@ void PerimeterGenerator::process_arachne()
                 }
 
                 perimeters.insert(perimeters.end(), inner_perimeters.begin(), inner_perimeters.end());
-                infill_contour = union_ex(top_expolygons, inner_wall_tool_paths.getInnerContour());
+                infill_contour = union_ex(top_expolygons, inner_wall_inner_contour);
             } else {
                 // There is no top surface ExPolygon, so we call Arachne again with parameters
                 // like when the single perimeter feature is disabled.
-                Arachne::WallToolPaths no_single_perimeter_tool_paths(last_p, bead_width_0, perimeter_spacing, coord_t(inner_loop_number + 2), wall_0_inset, layer_height, input_params_tmp);
-                perimeters     = no_single_perimeter_tool_paths.getToolPaths();
-                infill_contour = union_ex(no_single_perimeter_tool_paths.getInnerContour());
+                generate_wall_tool_paths(last_p, bead_width_0, perimeter_spacing, coord_t(inner_loop_number + 2), wall_0_inset, input_params_tmp, perimeters, inner_contour);
+                infill_contour = union_ex(inner_contour);
             }
         }
         //PS
@@ -2232,7 +2259,7 @@ void PerimeterGenerator::process_arachne()
         #ifdef ARACHNE_DEBUG
         {
             static int iRun = 0;
-            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(wallToolPaths.getInnerContour()));
+            export_perimeters_to_svg(debug_out_path("arachne-perimeters-%d-%d.svg", layer_id, iRun++), to_polygons(last), perimeters, union_ex(inner_contour));
         }
 #endif
 
@@ -2457,7 +2484,7 @@ void PerimeterGenerator::process_arachne()
                                     // Reverse internal only if the wall direction is auto
                                     this->config->overhang_reverse_internal_only && wall_direction == WallDirection::Auto);
             }
-            this->loops->append(extrusion_coll);
+            out.loops.append(extrusion_coll);
         }
 
         const coord_t spacing = (perimeters.size() == 1) ? ext_perimeter_spacing2 : perimeter_spacing;
@@ -2500,9 +2527,9 @@ void PerimeterGenerator::process_arachne()
         if (!top_expolygons.empty()) {
             infill_exp = union_ex(infill_exp, offset_ex(top_expolygons, double(top_inset)));
         }
-        this->fill_surfaces->append(infill_exp, stInternal);
+        out.fill_surfaces.append(infill_exp, stInternal);
 
-        apply_extra_perimeters(infill_exp);
+        apply_extra_perimeters(infill_exp, out.loops, out.fill_surfaces);
 
         // BBS: get the no-overlap infill expolygons
         {
@@ -2513,9 +2540,15 @@ void PerimeterGenerator::process_arachne()
                 float(+min_perimeter_infill_spacing / 2.));
             if (!top_expolygons.empty())
                 polyWithoutOverlap = union_ex(polyWithoutOverlap, top_expolygons);
-            this->fill_no_overlap->insert(this->fill_no_overlap->end(), polyWithoutOverlap.begin(), polyWithoutOverlap.end());
+            append(out.fill_no_overlap, std::move(polyWithoutOverlap));
         }
-    }
+    };
+    std::vector<IslandOutput> island_outputs(all_surfaces.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, all_surfaces.size()), [&](const tbb::blocked_range<size_t> &range) {
+        for (size_t surface_idx = range.begin(); surface_idx < range.end(); ++ surface_idx)
+            process_island(all_surfaces[surface_idx], island_outputs[surface_idx]);
+    });
+    this->append_island_outputs(island_outputs);
 }
 
 bool PerimeterGeneratorLoop::is_internal_contour() const
@@ -59,6 +59,8 @@ template<> struct hash<Slic3r::FuzzySkinConfig>
 
 namespace Slic3r {
 
+namespace Arachne { class WallToolPathsCache; }
+
 class PerimeterGenerator {
 public:
     // Inputs:
@@ -77,6 +79,8 @@ public:
     const PrintRegionConfig     *config;
     const PrintObjectConfig     *object_config;
     const PrintConfig           *print_config;
+    // Arachne results shared by the layers of the object, may be null.
+    Arachne::WallToolPathsCache *wall_tool_paths_cache { nullptr };
     // Outputs:
     ExtrusionEntityCollection   *loops;
     ExtrusionEntityCollection   *gap_fill;
@@ -137,9 +141,18 @@ public:
     Polygons    lower_slices_polygons() const { return m_lower_slices_polygons; }
 
 private:
+    // Outputs of a single island. The islands are processed in parallel, their outputs are appended in the order of the islands.
+    struct IslandOutput {
+        ExtrusionEntityCollection   loops;
+        ExtrusionEntityCollection   gap_fill;
+        SurfaceCollection           fill_surfaces;
+        ExPolygons                  fill_no_overlap;
+    };
+    void append_island_outputs(std::vector<IslandOutput> &island_outputs);
+
     std::vector<Polygons>     generate_lower_polygons_series(float width);
     void split_top_surfaces(const ExPolygons &orig_polygons, ExPolygons &top_fills, ExPolygons &non_top_polygons, ExPolygons &fill_clip) const;
-    void apply_extra_perimeters(ExPolygons& infill_area);
+    void apply_extra_perimeters(ExPolygons& infill_area, ExtrusionEntityCollection &loops, SurfaceCollection &fill_surfaces) const;
     void process_no_bridge(Surfaces& all_surfaces, coord_t perimeter_spacing, coord_t ext_perimeter_width);
 
 private:
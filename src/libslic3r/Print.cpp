@@ -24,11 +24,13 @@
 #include <algorithm>
 #include <limits>
 #include <unordered_set>
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/regex.hpp>
 #include <boost/nowide/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
@@ -89,13 +91,10 @@ bool Print::has_tpu_filament() const
     return false;
 }
 
-// Called by Print::apply().
-// This method only accepts PrintConfig option keys.
-bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+// Collects the Print steps and the PrintObject steps invalidated by a change of the given PrintConfig options.
+// Returns false if some of the options are not known, in which case all Print steps have to be invalidated.
+bool Print::steps_invalidated_by_config_options(const std::vector<t_config_option_key> &opt_keys, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps)
 {
-    if (opt_keys.empty())
-        return false;
-
     // Cache the plenty of parameters, which influence the G-code generator only,
     // or they are only notes not influencing the generated G-code.
     static std::unordered_set<std::string> steps_gcode = {
@@ -239,10 +238,7 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
 
     static std::unordered_set<std::string> steps_ignore;
 
-    std::vector<PrintStep> steps;
-    std::vector<PrintObjectStep> osteps;
-    bool invalidated = false;
-
+    bool all_steps = false;
     for (const t_config_option_key &opt_key : opt_keys) {
         if (steps_gcode.find(opt_key) != steps_gcode.end()) {
             // These options only affect G-code export or they are just notes without influence on the generated G-code,
@@ -394,10 +390,25 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
         } else {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
-            invalidated |= this->invalidate_all_steps();
+            all_steps = true;
             // Continue with the other opt_keys to possibly invalidate any object specific steps.
         }
     }
+    return ! all_steps;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintConfig option keys.
+bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
+    std::vector<PrintStep> steps;
+    std::vector<PrintObjectStep> osteps;
+    bool invalidated = false;
+    if (! steps_invalidated_by_config_options(opt_keys, steps, osteps))
+        invalidated |= this->invalidate_all_steps();
 
     sort_remove_duplicates(steps);
     for (PrintStep step : steps)
@@ -2017,6 +2028,9 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     if (m_objects.empty())
         return;
 
+    m_profiler.clear();
+    ProcessProfiler::StageScope profile(m_profiler, "process");
+
     for (PrintObject *obj : m_objects)
         obj->clear_shared_object();
 
@@ -2116,102 +2130,132 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
         }
     }
 
-    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": total object counts %1% in current print, need to slice %2%")%m_objects.size()%need_slicing_objects.size();
-    BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
+    // Objects placed differently from an object sliced before just by a rotation around Z or by mirroring take the slices
+    // of the volumes sharing their meshes over from that object transformed, see PrintObject::m_slicing_donor.
+    // Only the slicing is shared, the perimeters, infill and supports depend on the orientation of the object on the bed.
+    auto is_print_object_slicing_donor = [](const PrintObject *object, const PrintObject *donor) -> bool {
+        static constexpr const double eps = 1e-9;
+        const Matrix3d l = object->trafo().matrix().block<3, 3>(0, 0) * donor->trafo().matrix().block<3, 3>(0, 0).inverse();
+        if (std::abs(l(2, 0)) > eps || std::abs(l(2, 1)) > eps || std::abs(l(0, 2)) > eps || std::abs(l(1, 2)) > eps || std::abs(l(2, 2) - 1.) > eps)
+            return false;
+        for (const ModelVolume *volume : object->model_object()->volumes)
+            for (const ModelVolume *donor_volume : donor->model_object()->volumes)
+                if (volume->mesh_ptr() == donor_volume->mesh_ptr())
+                    return true;
+        return false;
+    };
+    std::vector<PrintObject*> slicing_donors;
     if (!use_cache) {
         for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->make_perimeters();
-            }
-            else {
-                if (obj->set_started(posSlice))
-                    obj->set_done(posSlice);
-                if (obj->set_started(posPerimeters))
-                    obj->set_done(posPerimeters);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->estimate_curled_extrusions();
-            }
-            else {
-                if (obj->set_started(posEstimateCurledExtrusions))
-                    obj->set_done(posEstimateCurledExtrusions);
-            }
+            obj->m_slicing_donor        = nullptr;
+            obj->m_shares_volume_slices = false;
         }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->infill();
-            }
-            else {
-                if (obj->set_started(posPrepareInfill))
-                    obj->set_done(posPrepareInfill);
-                if (obj->set_started(posInfill))
-                    obj->set_done(posInfill);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->ironing();
-            }
-            else {
-                if (obj->set_started(posIroning))
-                    obj->set_done(posIroning);
+        for (int index = 0; index < object_count; index++) {
+            PrintObject *obj = m_objects[index];
+            if (need_slicing_objects.count(obj) == 0 || obj->is_step_done(posSlice))
+                continue;
+            for (int donor_index = 0; donor_index < index; donor_index++) {
+                PrintObject *donor = m_objects[donor_index];
+                if (need_slicing_objects.count(donor) != 0 && donor->m_slicing_donor == nullptr && is_print_object_slicing_donor(obj, donor)) {
+                    obj->m_slicing_donor = donor;
+                    donor->m_shares_volume_slices = true;
+                    if (std::find(slicing_donors.begin(), slicing_donors.end(), donor) == slicing_donors.end())
+                        slicing_donors.emplace_back(donor);
+                    break;
+                }
             }
         }
+    }
 
-        tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size())),
-            [this, need_slicing_objects](const tbb::blocked_range<int>& range) {
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": total object counts %1% in current print, need to slice %2%")%m_objects.size()%need_slicing_objects.size();
+    BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
+    // The objects are processed independently of each other: each object runs its own chain of steps, thus an object
+    // with a few layers does not idle the cores at a step barrier while a tall object is still being processed.
+    // The steps parallelize over layers internally, TBB balances the load of both levels.
+    if (!use_cache) {
+        // The donors are sliced first, then the objects taking their slices over are processed together with the rest.
+        if (! slicing_donors.empty()) {
+            BOOST_LOG_TRIVIAL(info) << boost::format("Slicing %1% objects first to share their slices with the other objects") % slicing_donors.size();
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, slicing_donors.size(), 1),
+                [&slicing_donors](const tbb::blocked_range<size_t>& range) {
+                    for (size_t i = range.begin(); i < range.end(); ++ i)
+                        slicing_donors[i]->slice();
+                }
+            );
+        }
+        tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size()), 1),
+            [this, &need_slicing_objects](const tbb::blocked_range<int>& range) {
                 for (int i = range.begin(); i < range.end(); i++) {
                     PrintObject* obj = m_objects[i];
                     if (need_slicing_objects.count(obj) != 0) {
+                        obj->make_perimeters();
+                        obj->estimate_curled_extrusions();
+                        obj->infill();
+                        obj->ironing();
                         obj->generate_support_material();
+                        obj->detect_overhangs_for_lift();
                     }
                     else {
+                        if (obj->set_started(posSlice))
+                            obj->set_done(posSlice);
+                        if (obj->set_started(posPerimeters))
+                            obj->set_done(posPerimeters);
+                        if (obj->set_started(posEstimateCurledExtrusions))
+                            obj->set_done(posEstimateCurledExtrusions);
+                        if (obj->set_started(posPrepareInfill))
+                            obj->set_done(posPrepareInfill);
+                        if (obj->set_started(posInfill))
+                            obj->set_done(posInfill);
+                        if (obj->set_started(posIroning))
+                            obj->set_done(posIroning);
                         if (obj->set_started(posSupportMaterial))
                             obj->set_done(posSupportMaterial);
+                        if (obj->set_started(posDetectOverhangsForLift))
+                            obj->set_done(posDetectOverhangsForLift);
                     }
                 }
             }
         );
-
-        for (PrintObject* obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->detect_overhangs_for_lift();
-            }
-            else {
-                if (obj->set_started(posDetectOverhangsForLift))
-                    obj->set_done(posDetectOverhangsForLift);
-            }
-        }
     }
     else {
-        for (PrintObject *obj : m_objects) {
-            if (re_slicing_objects.count(obj) == 0) {
-                if (obj->set_started(posSlice))
-                    obj->set_done(posSlice);
-                if (obj->set_started(posPerimeters))
-                    obj->set_done(posPerimeters);
-                if (obj->set_started(posPrepareInfill))
-                    obj->set_done(posPrepareInfill);
-                if (obj->set_started(posInfill))
-                    obj->set_done(posInfill);
-                if (obj->set_started(posIroning))
-                    obj->set_done(posIroning);
-                if (obj->set_started(posSupportMaterial))
-                    obj->set_done(posSupportMaterial);
-                if (obj->set_started(posDetectOverhangsForLift))
-                    obj->set_done(posDetectOverhangsForLift);
-            }
-            else {
-                obj->make_perimeters();
-                obj->infill();
-                obj->ironing();
-                obj->generate_support_material();
-                obj->detect_overhangs_for_lift();
-                obj->estimate_curled_extrusions();
+        tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size()), 1),
+            [this, &re_slicing_objects](const tbb::blocked_range<int>& range) {
+                for (int i = range.begin(); i < range.end(); i++) {
+                    PrintObject* obj = m_objects[i];
+                    if (re_slicing_objects.count(obj) == 0) {
+                        if (obj->set_started(posSlice))
+                            obj->set_done(posSlice);
+                        if (obj->set_started(posPerimeters))
+                            obj->set_done(posPerimeters);
+                        if (obj->set_started(posPrepareInfill))
+                            obj->set_done(posPrepareInfill);
+                        if (obj->set_started(posInfill))
+                            obj->set_done(posInfill);
+                        if (obj->set_started(posIroning))
+                            obj->set_done(posIroning);
+                        if (obj->set_started(posSupportMaterial))
+                            obj->set_done(posSupportMaterial);
+                        if (obj->set_started(posDetectOverhangsForLift))
+                            obj->set_done(posDetectOverhangsForLift);
+                    }
+                    else {
+                        obj->make_perimeters();
+                        obj->infill();
+                        obj->ironing();
+                        obj->generate_support_material();
+                        obj->detect_overhangs_for_lift();
+                        obj->estimate_curled_extrusions();
+                    }
+                }
             }
-        }
+        );
+    }
+
+    // All the objects taking the slices of the donors over are sliced now.
+    for (PrintObject *donor : slicing_donors) {
+        donor->m_shares_volume_slices = false;
+        if (! m_retain_volume_slices)
+            std::vector<VolumeSliceCache>().swap(donor->m_volume_slice_cache);
     }
 
     for (PrintObject *obj : m_objects)
@@ -2225,6 +2269,7 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
 
 
     if (this->set_started(psWipeTower)) {
+        ProcessProfiler::StageScope profile_wipe_tower(m_profiler, "wipe_tower");
         {
             std::vector<std::set<int>> geometric_unprintables(m_config.nozzle_diameter.size());
             for (PrintObject* obj : m_objects) {
@@ -2260,6 +2305,7 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
 
     if (this->set_started(psSkirtBrim)) {
         this->set_status(70, L("Generating skirt & brim"));
+        ProcessProfiler::StageScope profile_skirt_brim(m_profiler, "skirt_brim");
 
         if (time_cost_with_cache)
             start_time = (long long)Slic3r::Utils::get_current_time_utc();
@@ -2453,7 +2499,17 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
     //BBS: compute plate offset for gcode-generator
     const Vec3d origin = this->get_plate_origin();
     gcode.set_gcode_offset(origin(0), origin(1));
-    gcode.do_export(this, path.c_str(), result, thumbnail_cb);
+    {
+        ProcessProfiler::StageScope profile(m_profiler, "gcode_export");
+        gcode.do_export(this, path.c_str(), result, thumbnail_cb);
+    }
+    if (gcode.released_extrusions()) {
+        // The G-code generator released the extrusions of the exported layers, the sequential export keeps them.
+        for (PrintObject *object : m_objects) {
+            object->invalidate_step(posPerimeters);
+            object->invalidate_step(posSupportMaterial);
+        }
+    }
     gcode.export_layer_filaments(result);
     //BBS
     result->conflict_result = m_conflict_result;
@@ -3590,6 +3646,8 @@ const std::string PrintStatistics::TotalFilamentUsedWipeTowerValueMask = "; tota
 #define JSON_ARC_FITTING            "arc_fitting"
 #define JSON_OBJECT_NAME            "name"
 #define JSON_IDENTIFY_ID          "identify_id"
+#define JSON_STEP_CACHE_STEP        "step"
+#define JSON_STEP_CACHE_KEY         "key"
 
 
 #define JSON_LAYERS                  "layers"
@@ -4322,54 +4380,490 @@ static void from_json(const json& j, groupedVolumeSlices& firstlayer_group)
     }
 }
 
-int Print::export_cached_data(const std::string& directory, bool with_space)
+static void convert_layer_to_json(json& layer_json, const Layer* layer)
 {
-    int ret = 0;
-    boost::filesystem::path directory_path(directory);
+    json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
+    layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
+    layer_json[JSON_LAYER_HEIGHT] = layer->height;
+    layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
+    layer_json[JSON_LAYER_ID] = layer->id();
+    //layer_json["slicing_errors"] = layer->slicing_errors;
 
-    auto convert_layer_to_json = [](json& layer_json, const Layer* layer) {
-        json slice_polygons_json = json::array(), slice_bboxs_json = json::array(), overhang_polygons_json = json::array(), layer_regions_json = json::array();
-        layer_json[JSON_LAYER_PRINT_Z] = layer->print_z;
-        layer_json[JSON_LAYER_HEIGHT] = layer->height;
-        layer_json[JSON_LAYER_SLICE_Z] = layer->slice_z;
-        layer_json[JSON_LAYER_ID] = layer->id();
-        //layer_json["slicing_errors"] = layer->slicing_errors;
+    //sliced_polygons
+    for (const ExPolygon& slice_polygon : layer->lslices) {
+        json slice_polygon_json = slice_polygon;
+        slice_polygons_json.push_back(std::move(slice_polygon_json));
+    }
+    layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
 
-        //sliced_polygons
-        for (const ExPolygon& slice_polygon : layer->lslices) {
-            json slice_polygon_json = slice_polygon;
-            slice_polygons_json.push_back(std::move(slice_polygon_json));
-        }
-        layer_json[JSON_LAYER_SLICED_POLYGONS] = std::move(slice_polygons_json);
+    //sliced_bbox
+    for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
+        json bbox_json = json::array();
 
-        //sliced_bbox
-        for (const BoundingBox& slice_bbox : layer->lslices_bboxes) {
-            json bbox_json = json::array();
+        bbox_json = slice_bbox;
+        slice_bboxs_json.push_back(std::move(bbox_json));
+    }
+    layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
 
-            bbox_json = slice_bbox;
-            slice_bboxs_json.push_back(std::move(bbox_json));
-        }
-        layer_json[JSON_LAYER_SLLICED_BBOXES] = std::move(slice_bboxs_json);
+    //overhang_polygons
+    for (const ExPolygon& overhang_polygon : layer->loverhangs) {
+        json overhang_polygon_json = overhang_polygon;
+        overhang_polygons_json.push_back(std::move(overhang_polygon_json));
+    }
+    layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
 
-        //overhang_polygons
-        for (const ExPolygon& overhang_polygon : layer->loverhangs) {
-            json overhang_polygon_json = overhang_polygon;
-            overhang_polygons_json.push_back(std::move(overhang_polygon_json));
-        }
-        layer_json[JSON_LAYER_OVERHANG_POLYGONS] = std::move(overhang_polygons_json);
+    //overhang_box
+    layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
+
+    for (const LayerRegion *layer_region : layer->regions()) {
+        json region_json = *layer_region;
+
+        layer_regions_json.push_back(std::move(region_json));
+    }
+    layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
+}
 
-        //overhang_box
-        layer_json[JSON_LAYER_OVERHANG_BBOX] = layer->loverhangs_bbox;
+// Binary slicing data: a compact, versioned alternative to the JSON files of export_cached_data().
+// File layout (native byte order, checked by the byte order mark):
+//   header:  magic "OSLD", u32 version, u32 byte order mark, u64 identify_id, string name,
+//            u64 layer_count, u64 support_layer_count,
+//            record table of (u64 offset, u64 size) for each layer, each support layer and the first layer groups.
+//   records: each record is self-contained, thus the layers are decoded independently of each other
+//            straight from the memory mapped file.
+// A layer record starts with its identity (id, heights, region config hashes) so that the layers and their regions
+// may be created in a cheap serial pass before the layer contents are materialized in parallel.
+#define SLICEDATA_BINARY_MAGIC          "OSLD"
+#define SLICEDATA_BINARY_VERSION        1
+#define SLICEDATA_BINARY_BYTE_ORDER     0x01020304
+#define SLICEDATA_BINARY_EXTENSION      ".slc"
+
+enum SliceDataEntityType : uint8_t {
+    sdePath,
+    sdeMultiPath,
+    sdeLoop,
+    sdeCollection
+};
 
-        for (const LayerRegion *layer_region : layer->regions()) {
-            json region_json = *layer_region;
+class SliceDataBinaryWriter
+{
+public:
+    std::string&    data() { return m_data; }
+
+    template<typename T> void write(const T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "only scalars are written directly");
+        m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void write_size(size_t size) { this->write<uint64_t>(uint64_t(size)); }
+    void write_string(const std::string &str) { this->write_size(str.size()); m_data.append(str); }
+    void write_point(const Point &pt) { this->write<int64_t>(pt.x()); this->write<int64_t>(pt.y()); }
+    void write_points(const Points &pts) {
+        static_assert(sizeof(Point) == 2 * sizeof(coord_t), "Point is expected to be densely packed");
+        this->write_size(pts.size());
+        if (! pts.empty())
+            m_data.append(reinterpret_cast<const char*>(pts.data()), pts.size() * sizeof(Point));
+    }
+    void write_bbox(const BoundingBox &bbox) { this->write_point(bbox.min); this->write_point(bbox.max); }
+    void write_expolygon(const ExPolygon &expolygon) {
+        this->write_points(expolygon.contour.points);
+        this->write_size(expolygon.holes.size());
+        for (const Polygon &hole : expolygon.holes)
+            this->write_points(hole.points);
+    }
+    void write_expolygons(const ExPolygons &expolygons) {
+        this->write_size(expolygons.size());
+        for (const ExPolygon &expolygon : expolygons)
+            this->write_expolygon(expolygon);
+    }
+    void write_surfaces(const Surfaces &surfaces) {
+        this->write_size(surfaces.size());
+        for (const Surface &surface : surfaces) {
+            this->write<int32_t>(surface.surface_type);
+            this->write_expolygon(surface.expolygon);
+            this->write<double>(surface.thickness);
+            this->write<uint16_t>(surface.thickness_layers);
+            this->write<double>(surface.bridge_angle);
+            this->write<uint16_t>(surface.extra_perimeters);
+        }
+    }
+    void write_arc(const ArcSegment &arc) {
+        this->write<uint8_t>(arc.is_arc);
+        this->write<double>(arc.length);
+        this->write<double>(arc.angle_radians);
+        this->write<double>(arc.polar_start_theta);
+        this->write<double>(arc.polar_end_theta);
+        this->write_point(arc.start_point);
+        this->write_point(arc.end_point);
+        this->write<int32_t>(int32_t(arc.direction));
+        this->write<double>(arc.radius);
+        this->write_point(arc.center);
+    }
+    void write_polyline(const Polyline &polyline) {
+        this->write_points(polyline.points);
+        this->write_size(polyline.fitting_result.size());
+        for (const PathFittingData &fitting : polyline.fitting_result) {
+            this->write_size(fitting.start_point_index);
+            this->write_size(fitting.end_point_index);
+            this->write<int32_t>(int32_t(fitting.path_type));
+            this->write<uint8_t>(fitting.arc_data.is_arc);
+            if (fitting.arc_data.is_arc)
+                this->write_arc(fitting.arc_data);
+        }
+    }
+    void write_path(const ExtrusionPath &path) {
+        this->write_polyline(path.polyline);
+        this->write<double>(path.mm3_per_mm);
+        this->write<float>(path.width);
+        this->write<float>(path.height);
+        this->write<int32_t>(path.role());
+        this->write<uint8_t>(path.is_force_no_extrusion());
+    }
+    void write_paths(const ExtrusionPaths &paths) {
+        this->write_size(paths.size());
+        for (const ExtrusionPath &path : paths)
+            this->write_path(path);
+    }
+    void write_entity(const ExtrusionEntity *entity) {
+        if (const auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(entity)) {
+            this->write<SliceDataEntityType>(sdeCollection);
+            this->write_collection(*collection);
+        } else if (const auto *path = dynamic_cast<const ExtrusionPath*>(entity)) {
+            this->write<SliceDataEntityType>(sdePath);
+            this->write_path(*path);
+        } else if (const auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(entity)) {
+            this->write<SliceDataEntityType>(sdeMultiPath);
+            this->write_paths(multipath->paths);
+        } else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(entity)) {
+            this->write<SliceDataEntityType>(sdeLoop);
+            this->write<int32_t>(loop->loop_role());
+            this->write_paths(loop->paths);
+        } else
+            throw Slic3r::FileIOError("Unknown extrusion entity type");
+    }
+    void write_collection(const ExtrusionEntityCollection &collection) {
+        this->write<uint8_t>(collection.no_sort);
+        this->write_size(collection.entities.size());
+        for (const ExtrusionEntity *entity : collection.entities)
+            this->write_entity(entity);
+    }
+
+private:
+    std::string     m_data;
+};
+
+class SliceDataBinaryReader
+{
+public:
+    SliceDataBinaryReader(const char *begin, const char *end) : m_ptr(begin), m_end(end) {}
+
+    template<typename T> T read() {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "only scalars are read directly");
+        T value;
+        this->read_raw(&value, sizeof(T));
+        return value;
+    }
+    size_t read_size() { return size_t(this->read<uint64_t>()); }
+    // Number of items stored next. Each item takes at least one byte, which guards the allocations against corrupted data.
+    size_t read_count() {
+        size_t count = this->read_size();
+        if (count > size_t(m_end - m_ptr))
+            throw Slic3r::FileIOError("Corrupted slicing data");
+        return count;
+    }
+    std::string read_string() {
+        std::string str(this->read_count(), '\0');
+        this->read_raw(str.data(), str.size());
+        return str;
+    }
+    Point read_point() {
+        coord_t x = coord_t(this->read<int64_t>());
+        coord_t y = coord_t(this->read<int64_t>());
+        return { x, y };
+    }
+    void read_points(Points &pts) {
+        pts.resize(this->read_count());
+        this->read_raw(pts.data(), pts.size() * sizeof(Point));
+    }
+    void read_bbox(BoundingBox &bbox) {
+        bbox.min = this->read_point();
+        bbox.max = this->read_point();
+        bbox.defined = true;
+    }
+    void read_expolygon(ExPolygon &expolygon) {
+        this->read_points(expolygon.contour.points);
+        expolygon.holes.resize(this->read_count());
+        for (Polygon &hole : expolygon.holes)
+            this->read_points(hole.points);
+    }
+    void read_expolygons(ExPolygons &expolygons) {
+        expolygons.resize(this->read_count());
+        for (ExPolygon &expolygon : expolygons)
+            this->read_expolygon(expolygon);
+    }
+    void read_surfaces(Surfaces &surfaces) {
+        size_t count = this->read_count();
+        surfaces.reserve(count);
+        for (size_t i = 0; i < count; ++ i) {
+            Surface surface(SurfaceType(this->read<int32_t>()));
+            this->read_expolygon(surface.expolygon);
+            surface.thickness        = this->read<double>();
+            surface.thickness_layers = this->read<uint16_t>();
+            surface.bridge_angle     = this->read<double>();
+            surface.extra_perimeters = this->read<uint16_t>();
+            surfaces.push_back(std::move(surface));
+        }
+    }
+    void read_arc(ArcSegment &arc) {
+        arc.is_arc            = this->read<uint8_t>() != 0;
+        arc.length            = this->read<double>();
+        arc.angle_radians     = this->read<double>();
+        arc.polar_start_theta = this->read<double>();
+        arc.polar_end_theta   = this->read<double>();
+        arc.start_point       = this->read_point();
+        arc.end_point         = this->read_point();
+        arc.direction         = ArcDirection(this->read<int32_t>());
+        arc.radius            = this->read<double>();
+        arc.center            = this->read_point();
+    }
+    void read_polyline(Polyline &polyline) {
+        this->read_points(polyline.points);
+        polyline.fitting_result.resize(this->read_count());
+        for (PathFittingData &fitting : polyline.fitting_result) {
+            fitting.start_point_index = this->read_size();
+            fitting.end_point_index   = this->read_size();
+            fitting.path_type         = EMovePathType(this->read<int32_t>());
+            if (this->read<uint8_t>())
+                this->read_arc(fitting.arc_data);
+        }
+    }
+    void read_path(ExtrusionPath &path) {
+        this->read_polyline(path.polyline);
+        path.mm3_per_mm = this->read<double>();
+        path.width      = this->read<float>();
+        path.height     = this->read<float>();
+        path.set_extrusion_role(ExtrusionRole(this->read<int32_t>()));
+        path.set_force_no_extrusion(this->read<uint8_t>() != 0);
+    }
+    void read_paths(ExtrusionPaths &paths) {
+        paths.resize(this->read_count());
+        for (ExtrusionPath &path : paths)
+            this->read_path(path);
+    }
+    ExtrusionEntity* read_entity() {
+        switch (this->read<SliceDataEntityType>()) {
+        case sdePath: {
+            auto path = std::make_unique<ExtrusionPath>();
+            this->read_path(*path);
+            return path.release();
+        }
+        case sdeMultiPath: {
+            auto multipath = std::make_unique<ExtrusionMultiPath>();
+            this->read_paths(multipath->paths);
+            return multipath.release();
+        }
+        case sdeLoop: {
+            auto loop = std::make_unique<ExtrusionLoop>();
+            loop->set_loop_role(ExtrusionLoopRole(this->read<int32_t>()));
+            this->read_paths(loop->paths);
+            return loop.release();
+        }
+        case sdeCollection: {
+            auto collection = std::make_unique<ExtrusionEntityCollection>();
+            this->read_collection(*collection);
+            return collection.release();
+        }
+        default:
+            throw Slic3r::FileIOError("Unknown extrusion entity type in slicing data");
+        }
+    }
+    void read_collection(ExtrusionEntityCollection &collection) {
+        collection.no_sort = this->read<uint8_t>() != 0;
+        size_t count = this->read_count();
+        collection.entities.reserve(count);
+        for (size_t i = 0; i < count; ++ i)
+            collection.entities.push_back(this->read_entity());
+    }
+
+private:
+    void read_raw(void *dst, size_t size) {
+        if (size_t(m_end - m_ptr) < size)
+            throw Slic3r::FileIOError("Truncated slicing data");
+        if (size > 0)
+            ::memcpy(dst, m_ptr, size);
+        m_ptr += size;
+    }
+
+    const char     *m_ptr;
+    const char     *m_end;
+};
+
+// Identity of a layer, stored at the start of its record.
+struct SliceDataLayerHeader
+{
+    size_t              id;
+    size_t              interface_id;
+    double              height;
+    double              print_z;
+    double              slice_z;
+    std::vector<size_t> region_config_hashes;
+};
+
+static void write_layer_binary(SliceDataBinaryWriter &writer, const Layer &layer, size_t interface_id)
+{
+    writer.write_size(layer.id());
+    writer.write_size(interface_id);
+    writer.write<double>(layer.height);
+    writer.write<double>(layer.print_z);
+    writer.write<double>(layer.slice_z);
+    writer.write_size(layer.region_count());
+    for (const LayerRegion *layer_region : layer.regions())
+        writer.write_size(layer_region->region().config_hash());
+
+    writer.write_expolygons(layer.lslices);
+    writer.write_size(layer.lslices_bboxes.size());
+    for (const BoundingBox &bbox : layer.lslices_bboxes)
+        writer.write_bbox(bbox);
+    writer.write_expolygons(layer.loverhangs);
+    writer.write_bbox(layer.loverhangs_bbox);
+
+    for (const LayerRegion *layer_region : layer.regions()) {
+        writer.write_surfaces(layer_region->slices.surfaces);
+        writer.write_expolygons(layer_region->raw_slices);
+        writer.write_collection(layer_region->thin_fills);
+        writer.write_expolygons(layer_region->fill_expolygons);
+        writer.write_surfaces(layer_region->fill_surfaces.surfaces);
+        writer.write_expolygons(layer_region->fill_no_overlap_expolygons);
+        writer.write_size(layer_region->unsupported_bridge_edges.size());
+        for (const Polyline &polyline : layer_region->unsupported_bridge_edges)
+            writer.write_polyline(polyline);
+        writer.write_collection(layer_region->perimeters);
+        writer.write_collection(layer_region->fills);
+    }
+}
+
+static void write_support_layer_binary(SliceDataBinaryWriter &writer, const SupportLayer &support_layer)
+{
+    write_layer_binary(writer, support_layer, support_layer.interface_id());
+    writer.write<int32_t>(support_layer.support_type);
+    writer.write_expolygons(support_layer.support_islands);
+    writer.write_collection(support_layer.support_fills);
+}
+
+static void read_layer_header_binary(SliceDataBinaryReader &reader, SliceDataLayerHeader &header)
+{
+    header.id           = reader.read_size();
+    header.interface_id = reader.read_size();
+    header.height       = reader.read<double>();
+    header.print_z      = reader.read<double>();
+    header.slice_z      = reader.read<double>();
+    header.region_config_hashes.resize(reader.read_count());
+    for (size_t &config_hash : header.region_config_hashes)
+        config_hash = reader.read_size();
+}
+
+// The layer regions are expected to be already created from the header.
+static void read_layer_binary(SliceDataBinaryReader &reader, Layer &layer)
+{
+    SliceDataLayerHeader header;
+    read_layer_header_binary(reader, header);
+    if (header.region_config_hashes.size() != layer.region_count())
+        throw Slic3r::FileIOError("Mismatching layer regions in slicing data");
+
+    reader.read_expolygons(layer.lslices);
+    layer.lslices_bboxes.resize(reader.read_count());
+    for (BoundingBox &bbox : layer.lslices_bboxes)
+        reader.read_bbox(bbox);
+    reader.read_expolygons(layer.loverhangs);
+    reader.read_bbox(layer.loverhangs_bbox);
+
+    for (LayerRegion *layer_region : layer.regions()) {
+        reader.read_surfaces(layer_region->slices.surfaces);
+        reader.read_expolygons(layer_region->raw_slices);
+        reader.read_collection(layer_region->thin_fills);
+        reader.read_expolygons(layer_region->fill_expolygons);
+        reader.read_surfaces(layer_region->fill_surfaces.surfaces);
+        reader.read_expolygons(layer_region->fill_no_overlap_expolygons);
+        layer_region->unsupported_bridge_edges.resize(reader.read_count());
+        for (Polyline &polyline : layer_region->unsupported_bridge_edges)
+            reader.read_polyline(polyline);
+        reader.read_collection(layer_region->perimeters);
+        reader.read_collection(layer_region->fills);
+    }
+}
 
-            layer_regions_json.push_back(std::move(region_json));
+static void read_support_layer_binary(SliceDataBinaryReader &reader, SupportLayer &support_layer)
+{
+    read_layer_binary(reader, support_layer);
+    support_layer.support_type = SupportInnerType(reader.read<int32_t>());
+    reader.read_expolygons(support_layer.support_islands);
+    reader.read_collection(support_layer.support_fills);
+}
+
+// Serialize the layers, support layers and first layer groups of a PrintObject into the binary slicing data format.
+static std::string export_object_binary(const PrintObject &object, size_t identify_id)
+{
+    const size_t num_layers         = object.layer_count();
+    const size_t num_support_layers = object.support_layer_count();
+    std::vector<std::string> records(num_layers + num_support_layers + 1);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_layers + num_support_layers),
+        [&object, &records, num_layers](const tbb::blocked_range<size_t>& range) {
+            for (size_t record_index = range.begin(); record_index < range.end(); ++ record_index) {
+                SliceDataBinaryWriter writer;
+                if (record_index < num_layers)
+                    write_layer_binary(writer, *object.get_layer(int(record_index)), 0);
+                else
+                    write_support_layer_binary(writer, *object.support_layers()[record_index - num_layers]);
+                records[record_index] = std::move(writer.data());
+            }
         }
-        layer_json[JSON_LAYER_REGIONS] = std::move(layer_regions_json);
+    );
 
-        return;
-    };
+    {
+        SliceDataBinaryWriter writer;
+        const std::vector<groupedVolumeSlices> &first_layer_obj_groups = object.firstLayerObjGroups();
+        const ModelVolumePtrs &volumes = object.model_object()->volumes;
+        writer.write_size(first_layer_obj_groups.size());
+        for (const groupedVolumeSlices &group : first_layer_obj_groups) {
+            writer.write<int32_t>(group.groupId);
+            writer.write_size(group.volume_ids.size());
+            // Volume IDs are stored as indices into the ModelObject's volumes, the IDs are not persistent.
+            for (const ObjectID &volume_id : group.volume_ids) {
+                auto it = std::find_if(volumes.begin(), volumes.end(), [&volume_id](const ModelVolume *volume) { return volume->id() == volume_id; });
+                writer.write_size(it == volumes.end() ? volume_id.id : size_t(it - volumes.begin()));
+            }
+            writer.write_expolygons(group.slices);
+        }
+        records.back() = std::move(writer.data());
+    }
+
+    SliceDataBinaryWriter header;
+    header.data().append(SLICEDATA_BINARY_MAGIC, 4);
+    header.write<uint32_t>(SLICEDATA_BINARY_VERSION);
+    header.write<uint32_t>(SLICEDATA_BINARY_BYTE_ORDER);
+    header.write_size(identify_id);
+    header.write_string(object.model_object()->name);
+    header.write_size(num_layers);
+    header.write_size(num_support_layers);
+    size_t offset = header.data().size() + records.size() * 2 * sizeof(uint64_t);
+    for (const std::string &record : records) {
+        header.write_size(offset);
+        header.write_size(record.size());
+        offset += record.size();
+    }
+
+    std::string out = std::move(header.data());
+    out.reserve(offset);
+    for (std::string &record : records) {
+        out += record;
+        record = std::string();
+    }
+    return out;
+}
+
+int Print::export_cached_data(const std::string& directory, bool with_space, bool binary)
+{
+    int ret = 0;
+    boost::filesystem::path directory_path(directory);
 
     //firstly clear this directory
     if (fs::exists(directory_path)) {
@@ -4390,6 +4884,7 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
     int count = 0;
     std::vector<std::string> filename_vector;
     std::vector<json> json_vector;
+    std::vector<std::string> binary_vector;
     for (PrintObject *obj : m_objects) {
         const ModelObject* model_obj = obj->model_object();
         if (obj->get_shared_object()) {
@@ -4400,10 +4895,23 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
         const PrintInstance &print_instance = obj->instances()[0];
         const ModelInstance *model_instance = print_instance.model_instance;
         size_t identify_id = (model_instance->loaded_id > 0)?model_instance->loaded_id: model_instance->id().id;
-        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
+        std::string file_name = directory +"/obj_"+std::to_string(identify_id)+(binary ? SLICEDATA_BINARY_EXTENSION : ".json");
 
         BOOST_LOG_TRIVIAL(info) << boost::format("begin to dump object %1%, identify_id %2% to %3%")%model_obj->name %identify_id %file_name;
 
+        if (binary) {
+            try {
+                binary_vector.push_back(export_object_binary(*obj, identify_id));
+                filename_vector.push_back(file_name);
+                count ++;
+            }
+            catch(std::exception &err) {
+                BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": save to "<<file_name<<" got a generic exception, reason = " << err.what();
+                ret = CLI_EXPORT_CACHE_WRITE_FAILED;
+            }
+            continue;
+        }
+
         try {
             json root_json, layers_json = json::array(), support_layers_json = json::array(), first_layer_groups = json::array();
 
@@ -4414,7 +4922,7 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
             std::vector<json> layers_json_vector(obj->layer_count());
             tbb::parallel_for(
                 tbb::blocked_range<size_t>(0, obj->layer_count()),
-                [&layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& layer_range) {
+                [&layers_json_vector, obj](const tbb::blocked_range<size_t>& layer_range) {
                     for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index) {
                         const Layer *layer = obj->get_layer(layer_index);
                         json layer_json;
@@ -4442,7 +4950,7 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
             std::vector<json> support_layers_json_vector(obj->support_layer_count());
             tbb::parallel_for(
                 tbb::blocked_range<size_t>(0, obj->support_layer_count()),
-                [&support_layers_json_vector, obj, convert_layer_to_json](const tbb::blocked_range<size_t>& support_layer_range) {
+                [&support_layers_json_vector, obj](const tbb::blocked_range<size_t>& support_layer_range) {
                     for (size_t s_layer_index = support_layer_range.begin(); s_layer_index < support_layer_range.end(); ++ s_layer_index) {
                         const SupportLayer *support_layer = obj->get_support_layer(s_layer_index);
                         json support_layer_json, support_islands_json = json::array(), support_fills_json, supportfills_entities_json = json::array();
@@ -4565,10 +5073,18 @@ int Print::export_cached_data(const std::string& directory, bool with_space)
     boost::mutex mutex;
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, filename_vector.size()),
-        [filename_vector, &json_vector, with_space, &ret, &mutex](const tbb::blocked_range<size_t>& output_range) {
+        [filename_vector, &json_vector, &binary_vector, binary, with_space, &ret, &mutex](const tbb::blocked_range<size_t>& output_range) {
             for (size_t object_index = output_range.begin(); object_index < output_range.end(); ++ object_index) {
                 try {
                     boost::nowide::ofstream c;
+                    if (binary) {
+                        c.open(filename_vector[object_index], std::ios::out | std::ios::trunc | std::ios::binary);
+                        c.write(binary_vector[object_index].data(), binary_vector[object_index].size());
+                        c.close();
+                        if (c.fail())
+                            throw Slic3r::FileIOError("write failed");
+                        continue;
+                    }
                     c.open(filename_vector[object_index], std::ios::out | std::ios::trunc);
                     if (with_space)
                         c << std::setw(4) << json_vector[object_index] << std::endl;
@@ -4629,6 +5145,15 @@ int Print::load_cached_data(const std::string& directory)
             BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": object %1%'s loaded_id is 0, need to use the instance_id %2%")%model_obj->name %identify_id;
             //continue;
         }
+        std::string binary_file_name = directory +"/obj_"+std::to_string(identify_id)+SLICEDATA_BINARY_EXTENSION;
+        if (fs::exists(binary_file_name)) {
+            int binary_ret = this->load_cached_object_binary(obj, binary_file_name);
+            if (binary_ret)
+                return binary_ret;
+            count ++;
+            continue;
+        }
+
         std::string file_name = directory +"/obj_"+std::to_string(identify_id)+".json";
 
         if (!fs::exists(file_name)) {
@@ -4806,6 +5331,298 @@ int Print::load_cached_data(const std::string& directory)
     return ret;
 }
 
+int Print::load_cached_object_binary(PrintObject *obj, const std::string &file_name)
+{
+    auto find_region = [obj](size_t config_hash) -> const PrintRegion* {
+        for (int index = 0; index < obj->num_printing_regions(); index++)
+            if (obj->printing_region(index).config_hash() == config_hash)
+                return &obj->printing_region(index);
+        return nullptr;
+    };
+
+    try {
+        // The layers are decoded straight from the mapped file, there is no intermediate representation of the whole object.
+        boost::iostreams::mapped_file_source file(file_name);
+        const char *data = file.data();
+        const size_t data_size = file.size();
+        if (data_size < 4 || ::memcmp(data, SLICEDATA_BINARY_MAGIC, 4) != 0) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": %1% is not a slicing data file")%file_name;
+            return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+        }
+
+        SliceDataBinaryReader header(data + 4, data + data_size);
+        uint32_t version = header.read<uint32_t>();
+        uint32_t byte_order = header.read<uint32_t>();
+        if (version != SLICEDATA_BINARY_VERSION || byte_order != SLICEDATA_BINARY_BYTE_ORDER) {
+            BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": unsupported version %1% or byte order of %2%")%version %file_name;
+            return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+        }
+        size_t      identify_id        = header.read_size();
+        std::string name               = header.read_string();
+        size_t      num_layers         = header.read_count();
+        size_t      num_support_layers = header.read_count();
+        std::vector<std::pair<size_t, size_t>> records(num_layers + num_support_layers + 1);
+        for (std::pair<size_t, size_t> &record : records) {
+            record.first  = header.read_size();
+            record.second = header.read_size();
+            if (record.first > data_size || record.second > data_size - record.first)
+                throw Slic3r::FileIOError("Invalid record table");
+        }
+        auto record_reader = [data, &records](size_t record_index) {
+            const std::pair<size_t, size_t> &record = records[record_index];
+            return SliceDataBinaryReader(data + record.first, data + record.first + record.second);
+        };
+
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__<<boost::format(":will load %1%, identify_id %2%, layer_count %3%, support_layer_count %4% from %5%")
+            %name %identify_id %num_layers %num_support_layers %file_name;
+
+        //create layers and layer regions from the record headers
+        SliceDataLayerHeader layer_header;
+        Layer* previous_layer = nullptr;
+        for (size_t index = 0; index < num_layers; index++) {
+            SliceDataBinaryReader reader = record_reader(index);
+            read_layer_header_binary(reader, layer_header);
+            Layer* new_layer = obj->add_layer(int(layer_header.id), layer_header.height, layer_header.print_z, layer_header.slice_z);
+            if (previous_layer) {
+                previous_layer->upper_layer = new_layer;
+                new_layer->lower_layer = previous_layer;
+            }
+            previous_layer = new_layer;
+            for (size_t config_hash : layer_header.region_config_hashes) {
+                const PrintRegion *print_region = find_region(config_hash);
+                if (!print_region) {
+                    BOOST_LOG_TRIVIAL(error) <<__FUNCTION__<< boost::format(":can not find print region of object %1%, layer %2%, print_z %3%")
+                        %name %index %new_layer->print_z;
+                    return CLI_IMPORT_CACHE_DATA_CAN_NOT_USE;
+                }
+                new_layer->add_region(print_region);
+            }
+        }
+
+        Layer* previous_support_layer = nullptr;
+        for (size_t index = 0; index < num_support_layers; index++) {
+            SliceDataBinaryReader reader = record_reader(num_layers + index);
+            read_layer_header_binary(reader, layer_header);
+            SupportLayer* new_support_layer = obj->add_support_layer(int(layer_header.id), int(layer_header.interface_id), layer_header.height, layer_header.print_z);
+            if (previous_support_layer) {
+                previous_support_layer->upper_layer = new_support_layer;
+                new_support_layer->lower_layer = previous_support_layer;
+            }
+            previous_support_layer = new_support_layer;
+        }
+
+        //materialize the layers and support layers in parallel
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, num_layers + num_support_layers),
+            [obj, num_layers, &record_reader](const tbb::blocked_range<size_t>& range) {
+                for (size_t record_index = range.begin(); record_index < range.end(); ++ record_index) {
+                    SliceDataBinaryReader reader = record_reader(record_index);
+                    if (record_index < num_layers)
+                        read_layer_binary(reader, *obj->get_layer(int(record_index)));
+                    else
+                        read_support_layer_binary(reader, *obj->get_support_layer(int(record_index - num_layers)));
+                }
+            }
+        );
+
+        //load first group volumes
+        SliceDataBinaryReader reader = record_reader(records.size() - 1);
+        std::vector<groupedVolumeSlices>& firstlayer_objgroups = obj->firstLayerObjGroupsMod();
+        const ModelVolumePtrs& volumes_ptr = obj->model_object()->volumes;
+        size_t firstlayer_group_count = reader.read_count();
+        for (size_t index = 0; index < firstlayer_group_count; index++) {
+            groupedVolumeSlices firstlayer_group;
+            firstlayer_group.groupId = reader.read<int32_t>();
+            firstlayer_group.volume_ids.resize(reader.read_count());
+            for (ObjectID& obj_id : firstlayer_group.volume_ids) {
+                size_t volume_index = reader.read_size();
+                if (volume_index >= volumes_ptr.size()) {
+                    BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< boost::format(": can not find volume_id %1% from object file %2% in firstlayer groups, volume_count %3%!")
+                        %volume_index %file_name %volumes_ptr.size();
+                    return CLI_IMPORT_CACHE_LOAD_FAILED;
+                }
+                obj_id = volumes_ptr[volume_index]->id();
+            }
+            reader.read_expolygons(firstlayer_group.slices);
+            firstlayer_objgroups.push_back(std::move(firstlayer_group));
+        }
+    }
+    catch(std::exception &err) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__<< ": load from "<<file_name<<" got a generic exception, reason = " << err.what();
+        return CLI_IMPORT_CACHE_LOAD_FAILED;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << __FUNCTION__<< boost::format(": load object from %1% successfully.")%file_name;
+    return 0;
+}
+
+// Persistent step cache: layers of a PrintObject are stored after posSlice, posPerimeters and posPrepareInfill
+// into "<step_cache_dir>/<step>_<key>.json", where the key is a content hash of all inputs of the step.
+static const char* step_cache_step_name(PrintObjectStep step)
+{
+    switch (step) {
+    case posSlice:          return "slice";
+    case posPerimeters:     return "perimeters";
+    case posPrepareInfill:  return "prepare_infill";
+    default:                assert(false); return "";
+    }
+}
+
+static std::string step_cache_file_path(const std::string &directory, PrintObjectStep step, const std::string &key)
+{
+    return (fs::path(directory) / (std::string(step_cache_step_name(step)) + "_" + key + ".json")).string();
+}
+
+// The adaptive cubic, support cubic and lightning infill generators are built from intermediate data of posPrepareInfill,
+// which is not stored, thus posPrepareInfill of objects using these infills is not cached.
+static bool step_cache_supports_prepare_infill(const PrintObject &object)
+{
+    auto [adaptive_line_spacing, support_line_spacing] = FillAdaptive::adaptive_fill_line_spacing(object);
+    if (adaptive_line_spacing != 0. || support_line_spacing != 0.)
+        return false;
+    for (size_t region_id = 0; region_id < object.num_printing_regions(); ++ region_id)
+        if (const PrintRegionConfig &config = object.printing_region(region_id).config(); config.sparse_infill_density > 0 && config.sparse_infill_pattern == ipLightning)
+            return false;
+    return true;
+}
+
+void PrintObject::store_to_step_cache(PrintObjectStep step) const
+{
+    const std::string &directory = m_print->step_cache_dir();
+    if (directory.empty() || m_shared_object || m_layers.empty() || (step == posPrepareInfill && ! step_cache_supports_prepare_infill(*this)))
+        return;
+
+    std::string key       = this->step_cache_key(step);
+    std::string file_name = step_cache_file_path(directory, step, key);
+    try {
+        if (fs::exists(file_name))
+            return;
+        fs::create_directories(directory);
+
+        json root_json, layers_json = json::array(), first_layer_groups = json::array();
+        root_json[JSON_STEP_CACHE_STEP] = step_cache_step_name(step);
+        root_json[JSON_STEP_CACHE_KEY]  = key;
+        root_json[JSON_OBJECT_NAME]     = this->model_object()->name;
+
+        std::vector<json> layers_json_vector(m_layers.size());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, m_layers.size()),
+            [this, &layers_json_vector](const tbb::blocked_range<size_t>& layer_range) {
+                for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index)
+                    convert_layer_to_json(layers_json_vector[layer_index], m_layers[layer_index]);
+            });
+        for (json &layer_json : layers_json_vector)
+            layers_json.push_back(std::move(layer_json));
+        root_json[JSON_LAYERS] = std::move(layers_json);
+
+        // Volume IDs are not persistent, store the volume indices instead.
+        const ModelVolumePtrs &volumes = this->model_object()->volumes;
+        for (groupedVolumeSlices group : firstLayerObjSliceByGroups) {
+            for (ObjectID &obj_id : group.volume_ids) {
+                auto it = std::find_if(volumes.begin(), volumes.end(), [&obj_id](const ModelVolume *volume) { return volume->id() == obj_id; });
+                obj_id.id = it - volumes.begin();
+            }
+            json first_layer_group_json = group;
+            first_layer_groups.push_back(std::move(first_layer_group_json));
+        }
+        root_json[JSON_FIRSTLAYER_GROUPS] = std::move(first_layer_groups);
+
+        // Write into a temporary file first, so that a concurrently running process never reads a partially written entry.
+        fs::path tmp_path = fs::unique_path(file_name + ".%%%%%%%%.tmp");
+        {
+            boost::nowide::ofstream c(tmp_path.string(), std::ios::out | std::ios::trunc);
+            c << root_json.dump(0) << std::endl;
+        }
+        fs::rename(tmp_path, file_name);
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": stored %1% of object %2% to %3%") % step_cache_step_name(step) % this->model_object()->name % file_name;
+    }
+    catch (std::exception &err) {
+        BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << ": storing " << file_name << " failed, reason = " << err.what();
+    }
+}
+
+PrintObjectStep PrintObject::restore_from_step_cache()
+{
+    const std::string &directory = m_print->step_cache_dir();
+    if (directory.empty() || m_shared_object)
+        return posCount;
+
+    auto find_region = [this](size_t config_hash) -> const PrintRegion* {
+        for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id)
+            if (this->printing_region(region_id).config_hash() == config_hash)
+                return &this->printing_region(region_id);
+        return nullptr;
+    };
+
+    // Try the most advanced step first.
+    for (PrintObjectStep step : { posPrepareInfill, posPerimeters, posSlice }) {
+        if (step == posPrepareInfill && ! step_cache_supports_prepare_infill(*this))
+            continue;
+        std::string key       = this->step_cache_key(step);
+        std::string file_name = step_cache_file_path(directory, step, key);
+        if (! fs::exists(file_name))
+            continue;
+
+        try {
+            json root_json;
+            {
+                boost::nowide::ifstream ifs(file_name);
+                ifs >> root_json;
+            }
+            if (root_json.at(JSON_STEP_CACHE_KEY) != key)
+                continue;
+
+            this->clear_layers();
+            firstLayerObjSliceByGroups.clear();
+
+            json  &layers_json    = root_json.at(JSON_LAYERS);
+            Layer *previous_layer = nullptr;
+            for (json &layer_json : layers_json) {
+                Layer *new_layer = this->add_layer(layer_json[JSON_LAYER_ID], layer_json[JSON_LAYER_HEIGHT], layer_json[JSON_LAYER_PRINT_Z], layer_json[JSON_LAYER_SLICE_Z]);
+                if (previous_layer) {
+                    previous_layer->upper_layer = new_layer;
+                    new_layer->lower_layer = previous_layer;
+                }
+                previous_layer = new_layer;
+                for (json &region_json : layer_json[JSON_LAYER_REGIONS]) {
+                    const PrintRegion *print_region = find_region(region_json[JSON_LAYER_REGION_CONFIG_HASH]);
+                    if (! print_region)
+                        throw Slic3r::RuntimeError("Print region of the cached layer not found");
+                    new_layer->add_region(print_region);
+                }
+            }
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, m_layers.size()),
+                [this, &layers_json](const tbb::blocked_range<size_t>& layer_range) {
+                    for (size_t layer_index = layer_range.begin(); layer_index < layer_range.end(); ++ layer_index)
+                        extract_layer(layers_json[layer_index], *m_layers[layer_index]);
+                });
+
+            const ModelVolumePtrs &volumes = this->model_object()->volumes;
+            for (json &first_layer_group_json : root_json.at(JSON_FIRSTLAYER_GROUPS)) {
+                groupedVolumeSlices group = first_layer_group_json;
+                for (ObjectID &obj_id : group.volume_ids) {
+                    if (obj_id.id >= volumes.size())
+                        throw Slic3r::RuntimeError("Volume of the cached first layer group not found");
+                    obj_id = volumes[obj_id.id]->id();
+                }
+                firstLayerObjSliceByGroups.push_back(std::move(group));
+            }
+
+            // detect_surfaces_type() of posPrepareInfill leaves the slices typed.
+            m_typed_slices = step == posPrepareInfill;
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": restored %1% of object %2% from %3%") % step_cache_step_name(step) % this->model_object()->name % file_name;
+            return step;
+        }
+        catch (std::exception &err) {
+            BOOST_LOG_TRIVIAL(warning) << __FUNCTION__ << ": restoring from " << file_name << " failed, reason = " << err.what();
+            this->clear_layers();
+            firstLayerObjSliceByGroups.clear();
+        }
+    }
+    return posCount;
+}
+
 BoundingBoxf3 PrintInstance::get_bounding_box() const {
     return print_object->model_object()->instance_bounding_box(*model_instance, false);
 }
@@ -17,6 +17,7 @@
 #include "GCode/ThumbnailData.hpp"
 #include "GCode/GCodeProcessor.hpp"
 #include "MultiMaterialSegmentation.hpp"
+#include "ProcessProfiler.hpp"
 #include "libslic3r.h"
 
 #include <Eigen/Geometry>
@@ -38,6 +39,7 @@ class SupportLayer;
 class TreeSupportData;
 class TreeSupport;
 class ExtrusionLayers;
+namespace Arachne { class WallToolPathsCache; }
 
 #define MAX_OUTER_NOZZLE_DIAMETER   4
 // BBS: move from PrintObjectSlice.cpp
@@ -47,6 +49,20 @@ struct VolumeSlices
     std::vector<ExPolygons> slices;
 };
 
+// Slices of a ModelVolume kept from the last slicing of a PrintObject, so that slicing the same mesh with the same parameters
+// again after the layer height profile, the layer ranges or the modifiers were edited only slices the new slicing planes.
+struct VolumeSliceCache
+{
+    ObjectID                            volume_id;
+    // Not owning, so that the cache does not keep a mesh replaced in the ModelVolume in memory.
+    std::weak_ptr<const TriangleMesh>   mesh;
+    // Including the transformation of the volume.
+    MeshSlicingParamsEx                 params;
+    // Sorted slicing planes and their slices.
+    std::vector<float>                  zs;
+    std::vector<ExPolygons>             slices;
+};
+
 struct groupedVolumeSlices
 {
     int                     groupId = -1;
@@ -351,6 +367,14 @@ public:
     double                      max_z() const         { return m_max_z; }
     // Centering offset of the sliced mesh from the scaled and rotated mesh of the model.
     const Point& 			     center_offset() const  { return m_center_offset; }
+    // Slices of the volumes kept from the last slicing, see Print::set_retain_volume_slices().
+    const std::vector<VolumeSliceCache>& volume_slice_cache() const { return m_volume_slice_cache; }
+    // Whether the last slicing took some slices over from another object placed differently, see m_slicing_donor.
+    bool                         slices_from_donor() const { return m_slices_from_donor; }
+    // Highest memory held by the avoidance and wall restriction caches of the last organic tree support generation,
+    // see Print::set_tree_support_avoidance_memory_budget().
+    size_t                       tree_support_avoidance_memory_peak() const { return m_tree_support_avoidance_memory_peak; }
+    void                         set_tree_support_avoidance_memory_peak(size_t bytes) { m_tree_support_avoidance_memory_peak = bytes; }
 
     // BBS
     void generate_support_preview();
@@ -394,6 +418,8 @@ public:
 
     // print_z: top of the layer; slice_z: center of the layer.
     Layer*          add_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
+    // Valid while make_perimeters() runs, null otherwise.
+    Arachne::WallToolPathsCache* wall_tool_paths_cache() const { return m_wall_tool_paths_cache.get(); }
 
     // BBS
     SupportLayer* add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z);
@@ -486,6 +512,24 @@ public:
     // It may be called for both the PrintObjectConfig and PrintRegionConfig.
     bool                    invalidate_state_by_config_options(
         const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+    // Collect the steps to be invalidated by invalidate_state_by_config_options() without invalidating them.
+    // Returns false if some of the options are unknown and all steps are to be invalidated.
+    bool                    steps_invalidated_by_config_options(
+        const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys,
+        std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const;
+    // Persistent cache of posSlice, posPerimeters and posPrepareInfill results, see Print::set_step_cache_dir().
+    // Bump STEP_CACHE_FORMAT_VERSION whenever the layout of the cache files changes, it is hashed into the cache key
+    // together with the slicer version, so that a cache directory written by another build is never reused.
+    static constexpr int    STEP_CACHE_FORMAT_VERSION = 1;
+    std::string             step_cache_key(PrintObjectStep step) const;
+    // Restores the most advanced step available in the cache, returns posCount if none was restored.
+    PrintObjectStep         restore_from_step_cache();
+    void                    store_to_step_cache(PrintObjectStep step) const;
+    // Called before this PrintObject is replaced by a new one after the modifiers, the layer ranges or the layer height profile
+    // of its ModelObject were edited: moves the perimeters of its layers aside to be reused by the replacing PrintObject.
+    void                    retain_layers_for_reuse();
+    // Takes over the volume slices and the layers retained by the PrintObject being replaced by this one.
+    void                    reuse_results_of(PrintObject &replaced);
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -493,6 +537,7 @@ public:
 
 private:
     void make_perimeters();
+    std::vector<unsigned char> reuse_perimeters();
     void prepare_infill();
     void infill();
     void ironing();
@@ -565,9 +610,29 @@ private:
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
 
+    // Slices of the volumes, only valid while slicing, see PrintObject::slice().
     std::vector < VolumeSlices >            firstLayerObjSliceByVolume;
     std::vector<groupedVolumeSlices>        firstLayerObjSliceByGroups;
 
+    // Slices of the ModelVolumes from the last slicing, sorted by ModelVolume::id().
+    // Only recorded if Print::retain_volume_slices() or if other objects take the slices of this one over.
+    std::vector<VolumeSliceCache>           m_volume_slice_cache;
+    // Set by Print::process() while other objects are to take the slices of this one over, see m_slicing_donor.
+    bool                                    m_shares_volume_slices { false };
+    // PrintObject sliced before this one, placed differently just by a rotation around Z, by mirroring or by a translation in XY.
+    // Slices of the volumes sharing their meshes with the donor are taken over from its m_volume_slice_cache transformed.
+    // Assigned by Print::process() for a single slicing.
+    const PrintObject                      *m_slicing_donor { nullptr };
+    bool                                    m_slices_from_donor { false };
+    size_t                                  m_tree_support_avoidance_memory_peak { 0 };
+    // Perimeters of the layers of the PrintObject replaced by this one, see retain_layers_for_reuse().
+    struct ReusableLayers;
+    std::unique_ptr<ReusableLayers>         m_reusable_layers;
+    // Per layer, whether its walls were taken over from the replaced PrintObject already simplified.
+    std::vector<unsigned char>              m_simplified_walls;
+    // Arachne results shared by the layers while generating the walls, see make_perimeters().
+    std::unique_ptr<Arachne::WallToolPathsCache> m_wall_tool_paths_cache;
+
     // BBS: per object skirt
     ExtrusionEntityCollection               m_skirt;
 
@@ -909,8 +974,15 @@ public:
     // If preview_data is not null, the preview_data is filled in for the G-code visualization (not used by the command line Slic3r).
     std::string         export_gcode(const std::string& path_template, GCodeProcessorResult* result, ThumbnailsGeneratorCallback thumbnail_cb = nullptr);
     //return 0 means successful
-    int                 export_cached_data(const std::string& dir_path, bool with_space=false);
+    // The binary format is compact and fast to load, the JSON format (optionally indented with with_space) is meant for debugging.
+    int                 export_cached_data(const std::string& dir_path, bool with_space=false, bool binary=true);
     int                 load_cached_data(const std::string& directory);
+    // Directory of the persistent cache of PrintObject step results, shared by subsequent runs. Empty to disable the cache.
+    void                set_step_cache_dir(const std::string &dir) { m_step_cache_dir = dir; }
+    const std::string&  step_cache_dir() const { return m_step_cache_dir; }
+    // Timing and memory statistics of the last process() and export_gcode(), recorded if enabled.
+    ProcessProfiler&        profiler() { return m_profiler; }
+    const ProcessProfiler&  profiler() const { return m_profiler; }
 
     // methods for handling state
     bool                is_step_done(PrintStep step) const { return Inherited::is_step_done(step); }
@@ -1079,6 +1151,20 @@ public:
 
     void set_check_multi_filaments_compatibility(bool check) { m_need_check_multi_filaments_compatibility = check; }
     bool need_check_multi_filaments_compatibility() const { return m_need_check_multi_filaments_compatibility; }
+    // Release the extrusions of the layers as soon as their G-code was generated, which lowers the peak memory of one-shot exports
+    // from the command line. The object steps producing the extrusions are invalidated by export_gcode().
+    void set_release_extrusions_on_export(bool release) { m_release_extrusions_on_export = release; }
+    bool release_extrusions_on_export() const { return m_release_extrusions_on_export; }
+    // Keep the slices of the volumes after slicing the PrintObjects, so that a following apply() editing the layer height profile,
+    // the layer ranges or the modifiers of an object only slices its changed layers. One-shot command line runs turn it off,
+    // as no later apply() can reuse the slices there.
+    void set_retain_volume_slices(bool retain) { m_retain_volume_slices = retain; }
+    bool retain_volume_slices() const { return m_retain_volume_slices; }
+    // Cap of the memory held by the avoidance and wall restriction caches of the organic tree supports of a single object in bytes,
+    // 0 for no cap. Above the cap the avoidance areas are partially recalculated by the support generator, trading time for memory.
+    // The collision and placeable area caches are not covered, see TreeModelVolumes::set_avoidance_memory_budget().
+    void set_tree_support_avoidance_memory_budget(size_t bytes) { m_tree_support_avoidance_memory_budget = bytes; }
+    size_t tree_support_avoidance_memory_budget() const { return m_tree_support_avoidance_memory_budget; }
 
     // scaled point
     Vec2d translate_to_print_space(const Point &point) const;
@@ -1118,6 +1204,10 @@ private:
 
     bool                has_tpu_filament() const;
     bool                invalidate_state_by_config_options(const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+    static bool         steps_invalidated_by_config_options(const std::vector<t_config_option_key> &opt_keys, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps);
+
+    // Load layers, support layers and first layer groups of a single object from the binary slicing data, return 0 on success.
+    int                 load_cached_object_binary(PrintObject *obj, const std::string &file_name);
 
     void                _make_skirt();
     void                _make_wipe_tower();
@@ -1178,6 +1268,12 @@ private:
     Calib_Params m_calib_params;
 
     bool m_need_check_multi_filaments_compatibility{true};
+    bool m_release_extrusions_on_export{false};
+    bool m_retain_volume_slices{true};
+    size_t m_tree_support_avoidance_memory_budget{0};
+
+    std::string m_step_cache_dir;
+    ProcessProfiler m_profiler;
 
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
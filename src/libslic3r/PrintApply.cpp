@@ -1414,6 +1414,8 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
                 // Reuse bounding boxes of print_objects_regions for ModelVolumes with unmodified transformation.
                 ModelObjectStatus::PrintObjectRegionsStatus::PartiallyValid;
             for (const PrintObjectStatus &print_object_status : print_objects_range) {
+                // Keep the perimeters of the layers, which the edit may not affect, for the PrintObject replacing this one.
+                print_object_status.print_object->retain_layers_for_reuse();
                 update_apply_status(print_object_status.print_object->invalidate_all_steps());
                 const_cast<PrintObjectStatus&>(print_object_status).status = PrintObjectStatus::Deleted;
             }
@@ -1525,11 +1527,20 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
                     PrintObject::object_config_from_model_object(m_default_object_config, *model_object, num_extruders ));
                 print_object_last = print_object;
             };
+            // A PrintObject replacing a deleted one with the same transformation re-slices and regenerates the perimeters of the changed layers only.
+            auto print_object_reuse_deleted = [&print_object_status_db, model_object](PrintObject *print_object) {
+                for (const PrintObjectStatus &print_object_status : print_object_status_db.get_range(*model_object))
+                    if (print_object_status.status == PrintObjectStatus::Deleted && transform3d_equal(print_object_status.trafo, print_object->trafo())) {
+                        print_object->reuse_results_of(*print_object_status.print_object);
+                        break;
+                    }
+            };
             if (old.empty()) {
                 // Simple case, just generate new instances.
                 for (PrintObjectTrafoAndInstances &print_instances : model_object_status.print_instances) {
                     PrintObject *print_object = new PrintObject(this, model_object, print_instances.trafo, std::move(print_instances.instances));
                     print_object_apply_config(print_object);
+                    print_object_reuse_deleted(print_object);
                     print_objects_new.emplace_back(print_object);
                     // print_object_status.emplace(PrintObjectStatus(print_object, PrintObjectStatus::New));
                     new_objects = true;
@@ -1547,6 +1558,7 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
                     // This is a new instance (or a set of instances with the same trafo). Just add it.
                     PrintObject *print_object = new PrintObject(this, model_object, new_instances.trafo, std::move(new_instances.instances));
                     print_object_apply_config(print_object);
+                    print_object_reuse_deleted(print_object);
                     print_objects_new.emplace_back(print_object);
                     // print_object_status.emplace(PrintObjectStatus(print_object, PrintObjectStatus::New));
                     new_objects = true;
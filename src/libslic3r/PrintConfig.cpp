@@ -10193,6 +10193,48 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "Allow filaments with high/low temperature to be printed together.";
     def->cli_params = "option";
     def->set_default_value(new  ConfigOptionBool(false));
+
+    def = this->add("slice_cache_dir", coString);
+    def->label = L("Slicing step cache");
+    def->tooltip = L("Directory of a persistent cache of object slicing, wall and infill preparation results. "
+                     "Results computed by previous runs with the same models and relevant settings are reused.");
+    def->cli_params = "slicing_cache_directory";
+    def->set_default_value(new ConfigOptionString(""));
+
+    def = this->add("batch_server", coBool);
+    def->label = L("Batch server");
+    def->tooltip = L("Keep running and read slicing jobs from the standard input, one JSON object per line: "
+                     "{\"id\": <any>, \"args\": [<command line arguments>]}. A line with the job id and its return code is printed "
+                     "for each finished job. The settings files loaded by the jobs are kept in memory for the following jobs.");
+    def->cli_params = "option";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("export_slicing_stats", coBool);
+    def->label = L("Export slicing statistics");
+    def->tooltip = L("Record wall time, CPU time, resident memory growth, peak resident memory growth and per-layer timing histograms "
+                     "of the slicing and G-code export stages and export them into slicing_stats_plate_<n>.json next to result.json.");
+    def->cli_params = "option";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("tree_support_avoidance_memory_budget", coInt);
+    def->label = L("Tree support avoidance memory budget");
+    def->tooltip = L("Cap of the memory in MB held by the avoidance and wall restriction areas of the organic tree supports of a single object. "
+                     "Above the cap only some layers of these areas are kept and the others are recalculated when needed, "
+                     "which lowers the peak memory of support heavy jobs at the cost of a longer support generation. "
+                     "The collision and placeable areas are not covered by the cap and stay in memory during the support generation. 0 for no cap.");
+    def->min = 0;
+    def->cli_params = "megabytes";
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("export_3mf_compression", coInt);
+    def->label = L("3MF compression level");
+    def->tooltip = L("Deflate level of the models and G-code stored into the 3MF exported by --export_3mf. "
+                     "0 stores them without compression for the fastest export, 1 is the fastest and 9 the tightest compression, "
+                     "-1 uses the default level.");
+    def->min = -1;
+    def->max = 9;
+    def->cli_params = "level";
+    def->set_default_value(new ConfigOptionInt(-1));
 }
 
 const CLIActionsConfigDef    cli_actions_config_def;
@@ -21,15 +21,20 @@
 #include "Format/STL.hpp"
 #include "format.hpp"
 #include "AABBTreeLines.hpp"
+#include "Arachne/WallToolPaths.hpp"
+#include "libslic3r_version.h"
 
 #include <float.h>
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/concurrent_vector.h>
 #include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/task_arena.h>
 #include <string_view>
 #include <utility>
 
 #include <boost/log/trivial.hpp>
+#include <boost/algorithm/hex.hpp>
+#include <boost/uuid/detail/md5.hpp>
 
 #include <tbb/parallel_for.h>
 #include <tbb/spin_mutex.h>
@@ -74,6 +79,40 @@ using namespace std::literals;
 
 namespace Slic3r {
 
+// Perimeters of the layers of a PrintObject, which was replaced by a new PrintObject of the same ModelObject with the same transformation,
+// together with the inputs they were generated from. Perimeters of a layer are reused if neither the layer nor its neighbors changed.
+struct PrintObject::ReusableLayers
+{
+    struct Region
+    {
+        // Index into ReusableLayers::region_configs.
+        size_t                      config_id;
+        // Untyped slices, the perimeters were generated from.
+        ExPolygons                  slices;
+        ExtrusionEntityCollection   perimeters;
+        ExtrusionEntityCollection   thin_fills;
+        ExPolygons                  fill_expolygons;
+        ExPolygons                  fill_no_overlap_expolygons;
+    };
+    struct Layer
+    {
+        coordf_t                    slice_z;
+        coordf_t                    print_z;
+        coordf_t                    height;
+        ExPolygons                  lslices;
+        // Regions with non-empty slices, ordered by their region ID.
+        std::vector<Region>         regions;
+    };
+
+    Point                           center_offset;
+    // The walls were simplified by PrintObject::simplify_extrusion_path() already.
+    bool                            walls_simplified;
+    PrintObjectConfig               object_config;
+    std::vector<PrintRegionConfig>  region_configs;
+    // Indexed by layer ID.
+    std::vector<Layer>              layers;
+};
+
 // Constructor is called from the main thread, therefore all Model / ModelObject / ModelIntance data are valid.
 PrintObject::PrintObject(Print* print, ModelObject* model_object, const Transform3d& trafo, PrintInstances&& instances) :
     PrintObjectBaseWithState(print, model_object),
@@ -419,11 +458,15 @@ void PrintObject::make_perimeters()
     // prerequisites
     this->slice();
 
-    if (! this->set_started(posPerimeters))
+    if (! this->set_started(posPerimeters)) {
+        // Perimeters are valid already, for example restored from the persistent step cache.
+        m_reusable_layers.reset();
         return;
+    }
 
     m_print->set_status(15, L("Generating walls"));
     BOOST_LOG_TRIVIAL(info) << "Generating walls..." << log_memory_info();
+    ProcessProfiler::StageScope profile(m_print->profiler(), "perimeters", this->model_object()->name);
 
     // Revert the typed slices into untyped slices.
     if (m_typed_slices) {
@@ -505,19 +548,47 @@ void PrintObject::make_perimeters()
         BOOST_LOG_TRIVIAL(debug) << "Generating extra perimeters for region " << region_id << " in parallel - end";
     }
 
+    // Take over the perimeters of the layers not affected by the edit, which replaced the previous PrintObject by this one.
+    std::vector<unsigned char> reused = this->reuse_perimeters();
+    if (m_reusable_layers && m_reusable_layers->walls_simplified)
+        m_simplified_walls = reused;
+    else
+        m_simplified_walls.clear();
+    m_reusable_layers.reset();
+
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
+    // Layers of prismatic objects share the Arachne results of their outlines.
+    // Each worker reuses the results of the layer below the one it processes, thus the cache has to keep the entries
+    // of one layer per worker, otherwise a layer with many islands would evict its own entries before they are reused.
+    // With only_one_wall_top, the outer wall and the inner walls of an island are generated separately, taking two entries.
+    size_t max_layer_entries = 0;
+    for (const Layer *layer : m_layers) {
+        size_t entries = 0;
+        for (const LayerRegion *layerm : layer->regions())
+            entries += layerm->slices.surfaces.size() * (layerm->region().config().only_one_wall_top ? 2 : 1);
+        max_layer_entries = std::max(max_layer_entries, entries);
+    }
+    m_wall_tool_paths_cache = std::make_unique<Arachne::WallToolPathsCache>(
+        std::max<size_t>(64, max_layer_entries * (size_t(tbb::this_task_arena::max_concurrency()) + 1)));
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
-        [this](const tbb::blocked_range<size_t>& range) {
+        [this, &profile, &reused](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
+                if (reused[layer_idx])
+                    continue;
+                ProcessProfiler::LayerScope profile_layer = profile.layer();
                 m_layers[layer_idx]->make_perimeters();
             }
         }
     );
+    m_wall_tool_paths_cache.reset();
     m_print->throw_if_canceled();
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
 
+    // Walls taken over already simplified would be simplified once more when restored from the step cache.
+    if (m_simplified_walls.empty())
+        this->store_to_step_cache(posPerimeters);
     this->set_done(posPerimeters);
 }
 
@@ -526,6 +597,7 @@ void PrintObject::prepare_infill()
     if (! this->set_started(posPrepareInfill))
         return;
     m_print->set_status(25, L("Generating infill regions"));
+    ProcessProfiler::StageScope profile(m_print->profiler(), "prepare_infill", this->model_object()->name);
     if (m_typed_slices) {
         // To improve robustness of detect_surfaces_type() when reslicing (working with typed slices), see GH issue #7442.
         // The preceding step (perimeter generator) only modifies extra_perimeters and the extra perimeters are only used by discover_vertical_shells()
@@ -657,6 +729,7 @@ void PrintObject::prepare_infill()
     } // for each layer
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
 
+    this->store_to_step_cache(posPrepareInfill);
     this->set_done(posPrepareInfill);
 }
 
@@ -667,15 +740,17 @@ void PrintObject::infill()
 
     if (this->set_started(posInfill)) {
         m_print->set_status(35, L("Generating infill toolpath"));
+        ProcessProfiler::StageScope profile(m_print->profiler(), "infill", this->model_object()->name);
         const auto& adaptive_fill_octree = this->m_adaptive_fill_octrees.first;
         const auto& support_fill_octree = this->m_adaptive_fill_octrees.second;
 
         BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
+            [this, &profile, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
+                    ProcessProfiler::LayerScope profile_layer = profile.layer();
                     m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
                 }
             }
@@ -692,13 +767,15 @@ void PrintObject::infill()
 void PrintObject::ironing()
 {
     if (this->set_started(posIroning)) {
+        ProcessProfiler::StageScope profile(m_print->profiler(), "ironing", this->model_object()->name);
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
         tbb::parallel_for(
             // Ironing starting with layer 0 to support ironing all surfaces.
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this](const tbb::blocked_range<size_t>& range) {
+            [this, &profile](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
+                    ProcessProfiler::LayerScope profile_layer = profile.layer();
                     m_layers[layer_idx]->make_ironing();
                 }
             }
@@ -731,6 +808,7 @@ void PrintObject::detect_overhangs_for_lift()
         size_t num_raft_layers = m_slicing_params.raft_layers();
 
         m_print->set_status(71, L("Detect overhangs for auto-lift"));
+        ProcessProfiler::StageScope profile(m_print->profiler(), "detect_overhangs_for_lift", this->model_object()->name);
 
         this->clear_overhangs_for_lift();
 
@@ -755,6 +833,7 @@ void PrintObject::detect_overhangs_for_lift()
 void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
+        ProcessProfiler::StageScope profile(m_print->profiler(), "support_material", this->model_object()->name);
         this->clear_support_layers();
 
         if(!has_support() && !m_print->get_no_check_flag()) {
@@ -802,6 +881,7 @@ void PrintObject::generate_support_material()
 void PrintObject::estimate_curled_extrusions()
 {
     if (this->set_started(posEstimateCurledExtrusions)) {
+        ProcessProfiler::StageScope profile(m_print->profiler(), "estimate_curled_extrusions", this->model_object()->name);
         if ( std::any_of(this->print()->m_print_regions.begin(), this->print()->m_print_regions.end(),
                         [](const PrintRegion *region) { return region->config().enable_overhang_speed.getBool(); })) {
 
@@ -822,6 +902,7 @@ void PrintObject::simplify_extrusion_path()
 {
     if (this->set_started(posSimplifyPath)) {
         m_print->set_status(75, L("Optimizing toolpath"));
+        ProcessProfiler::StageScope profile(m_print->profiler(), "simplify_path", this->model_object()->name);
         BOOST_LOG_TRIVIAL(debug) << "Simplify extrusion path of object in parallel - start";
         //BBS: infill and walls
         tbb::parallel_for(
@@ -829,11 +910,14 @@ void PrintObject::simplify_extrusion_path()
             [this](const tbb::blocked_range<size_t>& range) {
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
+                    if (layer_idx < m_simplified_walls.size() && m_simplified_walls[layer_idx])
+                        continue;
                     m_layers[layer_idx]->simplify_wall_extrusion_path();
                 }
             }
         );
         m_print->throw_if_canceled();
+        m_simplified_walls.clear();
         BOOST_LOG_TRIVIAL(debug) << "Simplify wall extrusion path of object in parallel - end";
         this->set_done(posSimplifyPath);
     }
@@ -933,6 +1017,126 @@ void PrintObject::clear_layers()
     }
 }
 
+// To be called from Print::apply() just before invalidating this PrintObject, while the PrintRegions of its layers are still valid.
+// The perimeters are moved out of the layers, as this PrintObject is going to be deleted.
+void PrintObject::retain_layers_for_reuse()
+{
+    m_reusable_layers.reset();
+    if (m_shared_object || m_shared_regions == nullptr || m_layers.empty() || ! this->is_step_done(posPerimeters))
+        return;
+
+    auto reusable = std::make_unique<ReusableLayers>();
+    reusable->center_offset = m_center_offset;
+    reusable->walls_simplified = this->is_step_done(posSimplifyPath);
+    reusable->object_config = m_config;
+    reusable->region_configs.reserve(m_shared_regions->all_regions.size());
+    for (const std::unique_ptr<PrintRegion> &region : m_shared_regions->all_regions)
+        reusable->region_configs.emplace_back(region->config());
+    reusable->layers.reserve(m_layers.size());
+    for (Layer *layer : m_layers) {
+        assert(layer->id() == reusable->layers.size());
+        assert(layer->m_regions.size() == reusable->region_configs.size());
+        ReusableLayers::Layer &dst = reusable->layers.emplace_back();
+        dst.slice_z = layer->slice_z;
+        dst.print_z = layer->print_z;
+        dst.height  = layer->height;
+        dst.lslices = std::move(layer->lslices);
+        for (size_t region_id = 0; region_id < layer->m_regions.size(); ++ region_id) {
+            // The perimeters were generated from the untyped slices, see Layer::restore_untyped_slices().
+            LayerRegion *layerm = layer->m_regions[region_id];
+            if (layerm->raw_slices.empty())
+                continue;
+            ReusableLayers::Region &region = dst.regions.emplace_back();
+            region.config_id                  = region_id;
+            region.slices                     = std::move(layerm->raw_slices);
+            region.perimeters                 = std::move(layerm->perimeters);
+            region.thin_fills                 = std::move(layerm->thin_fills);
+            region.fill_expolygons            = std::move(layerm->fill_expolygons);
+            region.fill_no_overlap_expolygons = std::move(layerm->fill_no_overlap_expolygons);
+        }
+    }
+    m_reusable_layers = std::move(reusable);
+}
+
+void PrintObject::reuse_results_of(PrintObject &replaced)
+{
+    m_volume_slice_cache = std::move(replaced.m_volume_slice_cache);
+    m_reusable_layers    = std::move(replaced.m_reusable_layers);
+}
+
+// Returns per layer whether its perimeters were taken over from m_reusable_layers.
+// Perimeters of a layer depend on its slices, on the slices of the layers below and above, on the layer's Z and ID and on the configuration.
+std::vector<unsigned char> PrintObject::reuse_perimeters()
+{
+    std::vector<unsigned char> reused(m_layers.size(), false);
+    if (! m_reusable_layers)
+        return reused;
+    const ReusableLayers &reusable = *m_reusable_layers;
+    if (m_layers.empty() || reusable.center_offset != m_center_offset || ! (reusable.object_config == m_config) ||
+        m_layers.front()->m_regions.size() != m_shared_regions->all_regions.size())
+        return reused;
+
+    // Map the current regions to the regions of the replaced PrintObject by their configuration, all regions of a PrintObject are distinct.
+    std::vector<int> region_map(m_shared_regions->all_regions.size(), -1);
+    for (size_t region_id = 0; region_id < region_map.size(); ++ region_id) {
+        const PrintRegionConfig &config = m_shared_regions->all_regions[region_id]->config();
+        auto it = std::find(reusable.region_configs.begin(), reusable.region_configs.end(), config);
+        if (it != reusable.region_configs.end())
+            region_map[region_id] = int(it - reusable.region_configs.begin());
+    }
+
+    auto slices_equal = [](const Surfaces &surfaces, const ExPolygons &expolygons) {
+        return surfaces.size() == expolygons.size() &&
+            std::equal(surfaces.begin(), surfaces.end(), expolygons.begin(), [](const Surface &s, const ExPolygon &e) { return s.expolygon == e; });
+    };
+    // Layers of the same ID, Z and slices of the same regions in the same order as the layers of the replaced PrintObject.
+    std::vector<unsigned char> unchanged(m_layers.size(), false);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, std::min(m_layers.size(), reusable.layers.size())),
+        [this, &reusable, &region_map, &slices_equal, &unchanged](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                const Layer                 &layer = *m_layers[layer_idx];
+                const ReusableLayers::Layer &old   = reusable.layers[layer_idx];
+                if (layer.slice_z != old.slice_z || layer.print_z != old.print_z || layer.height != old.height || layer.lslices != old.lslices)
+                    continue;
+                size_t num_regions = 0;
+                bool   equal       = true;
+                for (size_t region_id = 0; equal && region_id < layer.m_regions.size(); ++ region_id)
+                    if (const LayerRegion *layerm = layer.m_regions[region_id]; ! layerm->slices.empty())
+                        equal = num_regions < old.regions.size() && region_map[region_id] == int(old.regions[num_regions].config_id) &&
+                                slices_equal(layerm->slices.surfaces, old.regions[num_regions ++].slices);
+                unchanged[layer_idx] = equal && num_regions == old.regions.size();
+            }
+        });
+
+    auto neighbor_unchanged = [this, &reusable, &unchanged](size_t layer_idx) {
+        bool exists     = layer_idx < m_layers.size();
+        bool old_exists = layer_idx < reusable.layers.size();
+        return exists == old_exists && (! exists || unchanged[layer_idx]);
+    };
+    size_t num_reused = 0;
+    for (size_t layer_idx = 0; layer_idx < m_layers.size(); ++ layer_idx)
+        if (unchanged[layer_idx] && (layer_idx == 0 || unchanged[layer_idx - 1]) && neighbor_unchanged(layer_idx + 1)) {
+            Layer                 &layer = *m_layers[layer_idx];
+            ReusableLayers::Layer &old   = m_reusable_layers->layers[layer_idx];
+            size_t                 num_regions = 0;
+            for (LayerRegion *layerm : layer.m_regions)
+                if (! layerm->slices.empty()) {
+                    ReusableLayers::Region &region = old.regions[num_regions ++];
+                    layerm->perimeters                 = std::move(region.perimeters);
+                    layerm->thin_fills                 = std::move(region.thin_fills);
+                    layerm->fill_expolygons            = std::move(region.fill_expolygons);
+                    layerm->fill_no_overlap_expolygons = std::move(region.fill_no_overlap_expolygons);
+                    // The types of fill_surfaces are assigned by prepare_infill(), see LayerRegion::slices_to_fill_surfaces_clipped().
+                    layerm->fill_surfaces.set(layerm->fill_expolygons, stInternal);
+                }
+            reused[layer_idx] = true;
+            ++ num_reused;
+        }
+    BOOST_LOG_TRIVIAL(info) << "Reusing walls of " << num_reused << " out of " << m_layers.size() << " layers";
+    return reused;
+}
+
 Layer* PrintObject::add_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
     m_layers.emplace_back(new Layer(id, this, height, print_z, slice_z));
@@ -993,16 +1197,12 @@ SupportLayerPtrs::iterator PrintObject::insert_support_layer(SupportLayerPtrs::i
     return m_support_layers.insert(pos, new SupportLayer(id, interface_id, this, height, print_z, slice_z));
 }
 
-// Called by Print::apply().
-// This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
-bool PrintObject::invalidate_state_by_config_options(
-    const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys)
+// Collects the PrintObject steps and the Print steps invalidated by a change of the given PrintObjectConfig or PrintRegionConfig options.
+// Returns false if some of the options are not known, in which case all steps have to be invalidated.
+bool PrintObject::steps_invalidated_by_config_options(const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config,
+    const std::vector<t_config_option_key> &opt_keys, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const
 {
-    if (opt_keys.empty())
-        return false;
-
-    std::vector<PrintObjectStep> steps;
-    bool invalidated = false;
+    bool all_steps = false;
     for (const t_config_option_key &opt_key : opt_keys) {
         if (   opt_key == "brim_width"
             || opt_key == "brim_object_gap"
@@ -1325,29 +1525,133 @@ bool PrintObject::invalidate_state_by_config_options(
             || opt_key == "bed_mesh_max"
             || opt_key == "adaptive_bed_mesh_margin"
             || opt_key == "bed_mesh_probe_distance") {
-            invalidated |= m_print->invalidate_step(psGCodeExport);
+            print_steps.emplace_back(psGCodeExport);
         } else if (
                opt_key == "flush_into_infill"
             || opt_key == "flush_into_objects"
             || opt_key == "flush_into_support") {
-            invalidated |= m_print->invalidate_step(psWipeTower);
-            invalidated |= m_print->invalidate_step(psGCodeExport);
+            print_steps.emplace_back(psWipeTower);
+            print_steps.emplace_back(psGCodeExport);
         } else {
             // for legacy, if we can't handle this option let's invalidate all steps
-            this->invalidate_all_steps();
-            invalidated = true;
+            all_steps = true;
         }
     }
+    return ! all_steps;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
+bool PrintObject::invalidate_state_by_config_options(
+    const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
+    std::vector<PrintObjectStep> steps;
+    std::vector<PrintStep>       print_steps;
+    bool invalidated = false;
+    if (! this->steps_invalidated_by_config_options(old_config, new_config, opt_keys, steps, print_steps)) {
+        this->invalidate_all_steps();
+        invalidated = true;
+    }
 
+    sort_remove_duplicates(print_steps);
+    for (PrintStep step : print_steps)
+        invalidated |= m_print->invalidate_step(step);
     sort_remove_duplicates(steps);
     for (PrintObjectStep step : steps)
         invalidated |= this->invalidate_step(step);
     return invalidated;
 }
 
+// Content hash of everything the result of the given step depends on: the meshes and their transformations,
+// the layer height profile, the painted facets and the config options, which are tied to this step or any preceding step
+// by PrintObject::steps_invalidated_by_config_options() and Print::steps_invalidated_by_config_options().
+// Used as a key into the persistent step cache, see Print::set_step_cache_dir().
+std::string PrintObject::step_cache_key(PrintObjectStep step) const
+{
+    assert(step == posSlice || step == posPerimeters || step == posPrepareInfill);
+
+    using boost::uuids::detail::md5;
+    md5 md5_hash;
+    auto hash_bytes  = [&md5_hash](const void *data, size_t size) { md5_hash.process_bytes(data, size); };
+    auto hash_string = [&hash_bytes](const std::string &str) { hash_bytes(str.data(), str.size() + 1); };
+    auto hash_matrix = [&hash_bytes](const Transform3d &trafo) { hash_bytes(trafo.matrix().data(), sizeof(double) * 16); };
+    auto hash_facets = [&hash_bytes](const FacetsAnnotation &facets) {
+        const TriangleSelector::TriangleSplittingData &data = facets.get_data();
+        for (const TriangleSelector::TriangleBitStreamMapping &mapping : data.triangles_to_split)
+            hash_bytes(&mapping, sizeof(mapping));
+        std::vector<char> bits(data.bitstream.begin(), data.bitstream.end());
+        hash_bytes(bits.data(), bits.size());
+    };
+    // Does a change of an option invalidating these steps invalidate the result of the step?
+    // posEstimateCurledExtrusions does not propagate to the following steps, see PrintObject::invalidate_step().
+    auto affects_step = [step](const std::vector<PrintObjectStep> &steps) {
+        return std::any_of(steps.begin(), steps.end(), [step](PrintObjectStep s) { return s <= step && s != posEstimateCurledExtrusions; });
+    };
+    auto hash_config = [this, &hash_string, &affects_step](const ConfigBase &config, bool print_config) {
+        for (const t_config_option_key &opt_key : config.keys()) {
+            std::vector<PrintObjectStep> steps;
+            std::vector<PrintStep>       print_steps;
+            bool known = print_config ?
+                Print::steps_invalidated_by_config_options({ opt_key }, print_steps, steps) :
+                this->steps_invalidated_by_config_options(config, config, { opt_key }, steps, print_steps);
+            if (! known || affects_step(steps)) {
+                hash_string(opt_key);
+                hash_string(config.opt_serialize(opt_key));
+            }
+        }
+    };
+
+    // Results of another build or another cache file layout are not reused.
+    const int format_version = STEP_CACHE_FORMAT_VERSION;
+    hash_bytes(&format_version, sizeof(format_version));
+    hash_string(SLIC3R_VERSION);
+    hash_string(SoftFever_VERSION);
+    hash_string(GIT_COMMIT_HASH);
+
+    const ModelObject &model_object = *this->model_object();
+    hash_matrix(m_trafo);
+    hash_bytes(m_center_offset.data(), sizeof(coord_t) * 2);
+    for (const ModelVolume *model_volume : model_object.volumes) {
+        const indexed_triangle_set &its = model_volume->mesh().its;
+        int type = int(model_volume->type());
+        hash_bytes(&type, sizeof(type));
+        hash_bytes(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        hash_bytes(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        hash_matrix(model_volume->get_matrix());
+        hash_config(model_volume->config.get(), false);
+        hash_facets(model_volume->supported_facets);
+        hash_facets(model_volume->seam_facets);
+        hash_facets(model_volume->mmu_segmentation_facets);
+        hash_facets(model_volume->fuzzy_skin_facets);
+    }
+    std::vector<coordf_t> layer_height_profile = model_object.layer_height_profile.get();
+    hash_bytes(layer_height_profile.data(), layer_height_profile.size() * sizeof(coordf_t));
+    for (const auto &[range, config] : model_object.layer_config_ranges) {
+        hash_bytes(&range, sizeof(range));
+        hash_config(config.get(), false);
+    }
+    hash_config(model_object.config.get(), false);
+    hash_config(m_config, false);
+    for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id)
+        hash_config(this->printing_region(region_id).config(), false);
+    hash_config(m_print->config(), true);
+
+    md5::digest_type md5_digest{};
+    std::string      md5_digest_str;
+    md5_hash.get_digest(md5_digest);
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(md5_digest_str));
+    return md5_digest_str;
+}
+
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
+    if (step == posSlice || step == posPerimeters)
+        // The layers retained from the replaced PrintObject were produced with the configuration valid before this change.
+        m_reusable_layers.reset();
 
     // propagate to dependent steps
     if (step == posPerimeters) {
@@ -2,6 +2,8 @@
 
 #include <tbb/parallel_for.h>
 
+#include <numeric>
+
 #include "ClipperUtils.hpp"
 #include "ElephantFootCompensation.hpp"
 #include "I18N.hpp"
@@ -45,24 +47,160 @@ LayerPtrs new_layers(
     return out;
 }
 
+// Slices of a mesh sliced with the same parameters up to the transformation are interchangeable if the transformations
+// differ by an isometry in the XY plane: by a rotation around the Z axis, by mirroring and by a translation in the XY plane.
+// Vase mode slices the bottom layers differently based on the layer index, thus its slices are never reused.
+static bool volume_slice_params_compatible(const MeshSlicingParamsEx &params1, const MeshSlicingParamsEx &params2)
+{
+    return params1.slicing_mode_normal_below_layer == 0 && params2.slicing_mode_normal_below_layer == 0 &&
+           params1.mode == params2.mode && params1.closing_radius == params2.closing_radius &&
+           params1.extra_offset == params2.extra_offset && params1.resolution == params2.resolution;
+}
+
+// Returns true if trafo_dst = xy_isometry * trafo_src with xy_isometry being an isometry in the XY plane.
+// xy_isometry is returned in scaled coordinates.
+static bool slicing_trafos_differ_by_xy_isometry(const Transform3d &trafo_src, const Transform3d &trafo_dst, Transform2d &xy_isometry)
+{
+    static constexpr const double eps = 1e-9;
+    const Transform3d m = trafo_dst * trafo_src.inverse();
+    const auto        l = m.linear();
+    if (std::abs(l(2, 0)) > eps || std::abs(l(2, 1)) > eps || std::abs(l(0, 2)) > eps || std::abs(l(1, 2)) > eps ||
+        std::abs(l(2, 2) - 1.) > eps || std::abs(m.translation().z()) > eps)
+        return false;
+    const Matrix2d l2 = l.topLeftCorner<2, 2>();
+    if (((l2.transpose() * l2) - Matrix2d::Identity()).cwiseAbs().maxCoeff() > eps)
+        return false;
+    xy_isometry.setIdentity();
+    xy_isometry.linear()      = l2;
+    xy_isometry.translation() = Vec2d(scale_(m.translation().x()), scale_(m.translation().y()));
+    return true;
+}
+
+static void transform_slices(ExPolygons &expolygons, const Transform2d &xy_isometry, bool mirrored)
+{
+    auto transform_polygon = [&xy_isometry, mirrored](Polygon &polygon) {
+        for (Point &pt : polygon.points) {
+            Vec2d p = xy_isometry * pt.cast<double>();
+            pt = Point(coord_t(std::round(p.x())), coord_t(std::round(p.y())));
+        }
+        if (mirrored)
+            polygon.reverse();
+    };
+    for (ExPolygon &expolygon : expolygons) {
+        transform_polygon(expolygon.contour);
+        for (Polygon &hole : expolygon.holes)
+            transform_polygon(hole);
+    }
+}
+
+// Slices of a single volume to be reused by slice_volume() and the place to record the new slices into.
+struct VolumeSliceReuse
+{
+    // Slices of the same volume from the last slicing of the same PrintObject.
+    const VolumeSliceCache              *cached  { nullptr };
+    // Slices of the volumes of another PrintObject, which may be placed differently in the XY plane, see PrintObject::m_slicing_donor.
+    const std::vector<VolumeSliceCache> *donor   { nullptr };
+    VolumeSliceCache                    *out     { nullptr };
+    // Set if some slices were taken over from the donor.
+    bool                                *from_donor { nullptr };
+};
+
 // Slice single triangle mesh.
+// Slices at the planes found in reuse.cached are taken from there if the mesh and the slicing parameters did not change,
+// otherwise slices of the same mesh found in reuse.donor are transformed if the two volumes are placed differently just in the XY plane.
+// All the slices are recorded into reuse.out if provided.
 static std::vector<ExPolygons> slice_volume(
     const ModelVolume             &volume,
     const std::vector<float>      &zs,
     const MeshSlicingParamsEx     &params,
+    const VolumeSliceReuse        &reuse,
     const std::function<void()>   &throw_on_cancel_callback)
 {
     std::vector<ExPolygons> layers;
-    if (! zs.empty()) {
-        indexed_triangle_set its = volume.mesh().its;
-        if (its.indices.size() > 0) {
-            MeshSlicingParamsEx params2 { params };
-            params2.trafo = params2.trafo * volume.get_matrix();
-            if (params2.trafo.rotation().determinant() < 0.)
-                its_flip_triangles(its);
-            layers = slice_mesh_ex(its, zs, params2, throw_on_cancel_callback);
+    if (! zs.empty() && ! volume.mesh().its.indices.empty()) {
+        MeshSlicingParamsEx params2 { params };
+        params2.trafo = params2.trafo * volume.get_matrix();
+        const VolumeSliceCache *cache_in = nullptr;
+        Transform2d             xy_isometry;
+        // Slices of cache_in are copied as they are if the trafos match exactly.
+        bool                    identity = false;
+        if (reuse.cached != nullptr && reuse.cached->volume_id == volume.id() && reuse.cached->mesh.lock() == volume.mesh_ptr() &&
+            volume_slice_params_compatible(reuse.cached->params, params2) && reuse.cached->params.trafo.matrix() == params2.trafo.matrix()) {
+            cache_in = reuse.cached;
+            identity = true;
+        } else if (reuse.donor != nullptr) {
+            for (const VolumeSliceCache &donor : *reuse.donor)
+                if (donor.mesh.lock() == volume.mesh_ptr() && volume_slice_params_compatible(donor.params, params2) &&
+                    slicing_trafos_differ_by_xy_isometry(donor.params.trafo, params2.trafo, xy_isometry)) {
+                    cache_in = &donor;
+                    break;
+                }
+        }
+        // Indices of zs not found in cache_in.
+        std::vector<size_t> missing;
+        if (cache_in != nullptr) {
+            layers.assign(zs.size(), ExPolygons());
+            missing.reserve(zs.size());
+            // Pairs of (index into zs, index into cache_in).
+            std::vector<std::pair<size_t, size_t>> found;
+            found.reserve(zs.size());
+            auto it_cached = cache_in->zs.begin();
+            for (size_t i = 0; i < zs.size(); ++ i) {
+                it_cached = std::lower_bound(it_cached, cache_in->zs.end(), zs[i]);
+                if (it_cached != cache_in->zs.end() && *it_cached == zs[i])
+                    found.emplace_back(i, it_cached - cache_in->zs.begin());
+                else
+                    missing.emplace_back(i);
+            }
+            if (identity) {
+                for (const std::pair<size_t, size_t> &f : found)
+                    layers[f.first] = cache_in->slices[f.second];
+            } else {
+                if (reuse.from_donor != nullptr && ! found.empty())
+                    *reuse.from_donor = true;
+                const bool mirrored = xy_isometry.linear().determinant() < 0.;
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, found.size()),
+                    [cache_in, &found, &layers, &xy_isometry, mirrored, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+                        for (size_t i = range.begin(); i < range.end(); ++ i) {
+                            throw_on_cancel_callback();
+                            layers[found[i].first] = cache_in->slices[found[i].second];
+                            transform_slices(layers[found[i].first], xy_isometry, mirrored);
+                        }
+                    });
+            }
+        } else {
+            missing.assign(zs.size(), 0);
+            std::iota(missing.begin(), missing.end(), 0);
+        }
+        if (! missing.empty()) {
+            // Copy the mesh only if its triangles need to be flipped, a multi-million triangle mesh is not to be held in memory twice.
+            const indexed_triangle_set *its = &volume.mesh().its;
+            indexed_triangle_set        its_flipped;
+            if (params2.trafo.rotation().determinant() < 0.) {
+                its_flipped = *its;
+                its_flip_triangles(its_flipped);
+                its = &its_flipped;
+            }
+            if (missing.size() == zs.size()) {
+                layers = slice_mesh_ex(*its, zs, params2, throw_on_cancel_callback);
+            } else {
+                std::vector<float> zs_missing;
+                zs_missing.reserve(missing.size());
+                for (size_t i : missing)
+                    zs_missing.emplace_back(zs[i]);
+                std::vector<ExPolygons> sliced = slice_mesh_ex(*its, zs_missing, params2, throw_on_cancel_callback);
+                for (size_t i = 0; i < missing.size(); ++ i)
+                    layers[missing[i]] = std::move(sliced[i]);
+            }
             throw_on_cancel_callback();
         }
+        if (reuse.out != nullptr) {
+            reuse.out->volume_id = volume.id();
+            reuse.out->mesh      = volume.mesh_ptr();
+            reuse.out->params    = params2;
+            reuse.out->zs        = zs;
+            reuse.out->slices    = layers;
+        }
     }
     return layers;
 }
@@ -74,13 +212,14 @@ static std::vector<ExPolygons> slice_volume(
     const std::vector<float>                    &z,
     const std::vector<t_layer_height_range>     &ranges,
     const MeshSlicingParamsEx                   &params,
+    const VolumeSliceReuse                      &reuse,
     const std::function<void()>                 &throw_on_cancel_callback)
 {
     std::vector<ExPolygons> out;
     if (! z.empty() && ! ranges.empty()) {
         if (ranges.size() == 1 && z.front() >= ranges.front().first && z.back() < ranges.front().second) {
             // All layers fit into a single range.
-            out = slice_volume(volume, z, params, throw_on_cancel_callback);
+            out = slice_volume(volume, z, params, reuse, throw_on_cancel_callback);
         } else {
             std::vector<float>                     z_filtered;
             std::vector<std::pair<size_t, size_t>> n_filtered;
@@ -96,7 +235,7 @@ static std::vector<ExPolygons> slice_volume(
                     n_filtered.emplace_back(std::make_pair(first, i));
             }
             if (! n_filtered.empty()) {
-                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> layers = slice_volume(volume, z_filtered, params, reuse, throw_on_cancel_callback);
                 out.assign(z.size(), ExPolygons());
                 i = 0;
                 for (const std::pair<size_t, size_t> &span : n_filtered)
@@ -117,6 +256,8 @@ static inline bool model_volume_needs_slicing(const ModelVolume &mv)
 // Apply closing radius.
 // Apply positive XY compensation to ModelVolumeType::MODEL_PART and ModelVolumeType::PARAMETER_MODIFIER, not to ModelVolumeType::NEGATIVE_VOLUME.
 // Apply contour simplification.
+// Reuse the slices of cache_in (sorted by ModelVolume::id()) or of donor_cache where possible, record the new slices into cache_out if provided.
+// slices_from_donor is set if some slices were taken over from donor_cache.
 static std::vector<VolumeSlices> slice_volumes_inner(
     const PrintConfig                                        &print_config,
     const PrintObjectConfig                                  &print_object_config,
@@ -124,6 +265,10 @@ static std::vector<VolumeSlices> slice_volumes_inner(
     ModelVolumePtrs                                           model_volumes,
     const std::vector<PrintObjectRegions::LayerRangeRegions> &layer_ranges,
     const std::vector<float>                                 &zs,
+    const std::vector<VolumeSliceCache>                      &cache_in,
+    const std::vector<VolumeSliceCache>                      *donor_cache,
+    std::vector<VolumeSliceCache>                            *cache_out,
+    bool                                                     &slices_from_donor,
     const std::function<void()>                              &throw_on_cancel_callback)
 {
     model_volumes_sort_by_id(model_volumes);
@@ -158,8 +303,19 @@ static std::vector<VolumeSlices> slice_volumes_inner(
     //const auto   extra_offset  = is_mm_painted ? 0.f : std::max(0.f, float(print_object_config.xy_contour_compensation.value));
     const auto   extra_offset = 0.f;
 
+    if (cache_out != nullptr) {
+        cache_out->clear();
+        cache_out->reserve(model_volumes.size());
+    }
+
     for (const ModelVolume *model_volume : model_volumes)
         if (model_volume_needs_slicing(*model_volume)) {
+            auto it_cache_in = lower_bound_by_predicate(cache_in.begin(), cache_in.end(), [model_volume](const VolumeSliceCache &c) { return c.volume_id < model_volume->id(); });
+            VolumeSliceReuse reuse;
+            reuse.cached = it_cache_in != cache_in.end() && it_cache_in->volume_id == model_volume->id() ? &(*it_cache_in) : nullptr;
+            reuse.donor  = donor_cache;
+            reuse.from_donor = &slices_from_donor;
+            reuse.out    = cache_out != nullptr ? &cache_out->emplace_back() : nullptr;
             MeshSlicingParamsEx params { params_base };
             if (! model_volume->is_negative_volume())
                 params.extra_offset = extra_offset;
@@ -178,7 +334,7 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                     }
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, params, reuse, throw_on_cancel_callback)
                     });
                 }
             } else {
@@ -190,11 +346,14 @@ static std::vector<VolumeSlices> slice_volumes_inner(
                 if (! slicing_ranges.empty())
                     out.push_back({
                         model_volume->id(),
-                        slice_volume(*model_volume, zs, slicing_ranges, params, throw_on_cancel_callback)
+                        slice_volume(*model_volume, zs, slicing_ranges, params, reuse, throw_on_cancel_callback)
                     });
             }
             if (! out.empty() && out.back().slices.empty())
                 out.pop_back();
+            if (cache_out != nullptr && cache_out->back().mesh.expired())
+                // Nothing was sliced.
+                cache_out->pop_back();
         }
 
     return out;
@@ -792,6 +951,15 @@ void PrintObject::slice()
         return;
     //BBS: add flag to reload scene for shell rendering
     m_print->set_status(5, L("Slicing mesh"), PrintBase::SlicingStatus::RELOAD_SCENE);
+    ProcessProfiler::StageScope profile(m_print->profiler(), "slice", this->model_object()->name);
+    // Results of this step and possibly of the following steps may be available in the persistent step cache.
+    if (PrintObjectStep restored_step = this->restore_from_step_cache(); restored_step != posCount) {
+        this->set_done(posSlice);
+        for (PrintObjectStep step : { posPerimeters, posPrepareInfill })
+            if (step <= restored_step && this->set_started(step))
+                this->set_done(step);
+        return;
+    }
     std::vector<coordf_t> layer_height_profile;
     this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
     m_print->throw_if_canceled();
@@ -820,6 +988,8 @@ void PrintObject::slice()
 
     // BBS: the actual first layer slices stored in layers are re-sorted by volume group and will be used to generate brim
     groupingVolumesForBrim(this, m_layers, firstLayerReplacedBy);
+    // The slices of all the volumes at all the layers were copied by slice_volumes() just for the grouping above, release them.
+    std::vector<VolumeSlices>().swap(firstLayerObjSliceByVolume);
 
     // Update bounding boxes, back up raw slices of complex models.
     tbb::parallel_for(
@@ -838,6 +1008,7 @@ void PrintObject::slice()
     if (m_layers.empty())
         throw Slic3r::SlicingError(L("No layers were detected. You might want to repair your STL file(s) or check their size or thickness and retry.\n"));
 
+    this->store_to_step_cache(posSlice);
     // BBS
     this->set_done(posSlice);
 }
@@ -1139,11 +1310,23 @@ void PrintObject::slice_volumes()
 
     std::vector<float>                   slice_zs      = zs_from_layers(m_layers);
     std::vector<VolumeSlices> objSliceByVolume;
+    m_slices_from_donor = false;
     if (!slice_zs.empty()) {
+        // The slices are recorded only if they may be reused by the next slicing of this object or by the objects taking them over,
+        // a one-shot slicing does not keep a copy of all the slices of all the volumes.
+        const bool                    record_slices = print->retain_volume_slices() || m_shares_volume_slices;
+        std::vector<VolumeSliceCache> volume_slice_cache;
         objSliceByVolume = slice_volumes_inner(
             print->config(), this->config(), this->trafo_centered(),
-            this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, throw_on_cancel_callback);
+            this->model_object()->volumes, m_shared_regions->layer_ranges, slice_zs, m_volume_slice_cache,
+            m_slicing_donor ? &m_slicing_donor->m_volume_slice_cache : nullptr, record_slices ? &volume_slice_cache : nullptr,
+            m_slices_from_donor, throw_on_cancel_callback);
+        m_volume_slice_cache = std::move(volume_slice_cache);
+        if (m_slices_from_donor)
+            BOOST_LOG_TRIVIAL(info) << "Slices of object " << this->model_object()->name << " were taken over from a copy placed differently";
     }
+    // The donor may be deleted by the next Print::apply().
+    m_slicing_donor = nullptr;
 
     //BBS: "model_part" volumes are grouded according to their connections
     //const auto           scaled_resolution = scaled<double>(print->config().resolution.value);
@@ -1531,7 +1714,7 @@ std::vector<Polygons> PrintObject::slice_support_volumes(const ModelVolumeType m
         params.trafo = this->trafo_centered();
         for (; it_volume != it_volume_end; ++ it_volume)
             if ((*it_volume)->type() == model_volume_type) {
-                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, throw_on_cancel_callback);
+                std::vector<ExPolygons> slices2 = slice_volume(*(*it_volume), zs, params, VolumeSliceReuse(), throw_on_cancel_callback);
                 if (slices.empty()) {
                     slices.reserve(slices2.size());
                     for (ExPolygons &src : slices2)
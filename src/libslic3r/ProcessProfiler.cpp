@@ -0,0 +1,109 @@
+#include "ProcessProfiler.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "nlohmann/json.hpp"
+
+namespace Slic3r {
+
+ProcessProfiler::LayerScope::~LayerScope()
+{
+    if (m_stage)
+        m_stage->add_layer_time(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count());
+}
+
+ProcessProfiler::StageScope::StageScope(ProcessProfiler &profiler, const char *name, const std::string &object) :
+    m_profiler(profiler.enabled() ? &profiler : nullptr)
+{
+    if (m_profiler) {
+        m_stage.name        = name;
+        m_stage.object      = object;
+        m_start             = std::chrono::steady_clock::now();
+        m_cpu_time_start    = process_cpu_time();
+        m_memory_start      = current_memory_usage();
+        m_peak_memory_start = peak_memory_usage();
+    }
+}
+
+ProcessProfiler::StageScope::~StageScope()
+{
+    if (m_profiler) {
+        m_stage.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        m_stage.cpu_time  = process_cpu_time() - m_cpu_time_start;
+        m_stage.memory_delta = int64_t(current_memory_usage()) - int64_t(m_memory_start);
+        size_t peak_memory = peak_memory_usage();
+        m_stage.peak_memory_delta = peak_memory > m_peak_memory_start ? peak_memory - m_peak_memory_start : 0;
+        m_profiler->add_stage(std::move(m_stage));
+    }
+}
+
+void ProcessProfiler::StageScope::add_layer_time(double seconds)
+{
+    // Bin 0 collects times below 1ms, bin i collects times in [2^(i-1), 2^i) ms.
+    double ms  = seconds * 1000.;
+    size_t bin = ms < 1. ? 0 : std::min(NUM_LAYER_BINS - 1, size_t(std::floor(std::log2(ms))) + 1);
+    std::lock_guard<std::mutex> lock(m_layers_mutex);
+    ++ m_stage.num_layers;
+    m_stage.layers_time += seconds;
+    m_stage.max_layer_time = std::max(m_stage.max_layer_time, seconds);
+    ++ m_stage.layer_histogram[bin];
+}
+
+void ProcessProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stages.clear();
+}
+
+std::vector<ProcessProfiler::Stage> ProcessProfiler::stages() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stages;
+}
+
+void ProcessProfiler::add_stage(Stage &&stage)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stages.emplace_back(std::move(stage));
+}
+
+std::string ProcessProfiler::to_json() const
+{
+    nlohmann::json root, stages_json = nlohmann::json::array();
+    for (const Stage &stage : this->stages()) {
+        nlohmann::json stage_json;
+        stage_json["name"]              = stage.name;
+        if (! stage.object.empty())
+            stage_json["object"]        = stage.object;
+        stage_json["wall_time"]         = stage.wall_time;
+        stage_json["cpu_time"]          = stage.cpu_time;
+        stage_json["memory_delta"]      = stage.memory_delta;
+        stage_json["peak_memory_delta"] = stage.peak_memory_delta;
+        if (stage.num_layers > 0) {
+            nlohmann::json layers_json, histogram_json = nlohmann::json::array();
+            layers_json["count"]      = stage.num_layers;
+            layers_json["total_time"] = stage.layers_time;
+            layers_json["max_time"]   = stage.max_layer_time;
+            // Drop the empty bins at the end of the histogram, the upper bound of a bin is given in milliseconds.
+            size_t num_bins = NUM_LAYER_BINS;
+            while (num_bins > 0 && stage.layer_histogram[num_bins - 1] == 0)
+                -- num_bins;
+            for (size_t bin = 0; bin < num_bins; ++ bin) {
+                nlohmann::json bin_json;
+                if (bin + 1 < NUM_LAYER_BINS)
+                    bin_json["upper_bound_ms"] = size_t(1) << bin;
+                bin_json["count"] = stage.layer_histogram[bin];
+                histogram_json.push_back(std::move(bin_json));
+            }
+            layers_json["histogram"] = std::move(histogram_json);
+            stage_json["layers"] = std::move(layers_json);
+        }
+        stages_json.push_back(std::move(stage_json));
+    }
+    root["stages"] = std::move(stages_json);
+    return root.dump(4);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,99 @@
+#ifndef slic3r_ProcessProfiler_hpp_
+#define slic3r_ProcessProfiler_hpp_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+// Records wall time, CPU time, the resident memory growth and the growth of the peak resident memory of the stages of Print::process()
+// and of the G-code export, together with a histogram of the per-layer times of the stages processing the layers in parallel.
+// The profiler is disabled by default, then the stage and layer scopes cost a single branch.
+class ProcessProfiler
+{
+public:
+    // Per-layer times are binned by powers of two: [0, 1ms), [1ms, 2ms), [2ms, 4ms) ..., the last bin is unbounded.
+    static constexpr size_t NUM_LAYER_BINS = 16;
+
+    struct Stage
+    {
+        std::string name;
+        // Name of the object the stage was executed for, empty for the stages of the whole Print.
+        std::string object;
+        // Seconds.
+        double      wall_time { 0. };
+        // Seconds of CPU time consumed by the whole process (all threads) while the stage was running.
+        double      cpu_time { 0. };
+        // Growth of the resident memory of the process from the start to the end of the stage, in bytes.
+        // Negative if the stage released more memory than it kept.
+        int64_t     memory_delta { 0 };
+        // Growth of the high-water mark of the resident memory of the process while the stage was running, in bytes.
+        // Zero for any stage that does not exceed the peak reached by the process before the stage started.
+        size_t      peak_memory_delta { 0 };
+        // Layers timed by LayerScope.
+        size_t      num_layers { 0 };
+        double      layers_time { 0. };
+        double      max_layer_time { 0. };
+        std::array<size_t, NUM_LAYER_BINS> layer_histogram {};
+    };
+
+    class StageScope;
+
+    // Times a single layer of a stage. Layer scopes of a single stage may be alive in multiple threads at once.
+    class LayerScope
+    {
+    public:
+        explicit LayerScope(StageScope *stage) : m_stage(stage) { if (m_stage) m_start = std::chrono::steady_clock::now(); }
+        LayerScope(LayerScope &&rhs) : m_stage(rhs.m_stage), m_start(rhs.m_start) { rhs.m_stage = nullptr; }
+        ~LayerScope();
+
+    private:
+        StageScope                              *m_stage;
+        std::chrono::steady_clock::time_point    m_start;
+    };
+
+    // Times a stage from its construction until its destruction, the stage is recorded even if an exception is thrown.
+    class StageScope
+    {
+    public:
+        StageScope(ProcessProfiler &profiler, const char *name, const std::string &object = std::string());
+        ~StageScope();
+
+        LayerScope layer() { return LayerScope(m_profiler ? this : nullptr); }
+
+    private:
+        friend class LayerScope;
+        void add_layer_time(double seconds);
+
+        // nullptr if the profiler is disabled.
+        ProcessProfiler                         *m_profiler;
+        Stage                                    m_stage;
+        std::chrono::steady_clock::time_point    m_start;
+        double                                   m_cpu_time_start { 0. };
+        size_t                                   m_memory_start { 0 };
+        size_t                                   m_peak_memory_start { 0 };
+        std::mutex                               m_layers_mutex;
+    };
+
+    bool                enabled() const { return m_enabled; }
+    void                set_enabled(bool enabled) { m_enabled = enabled; }
+    void                clear();
+    std::vector<Stage>  stages() const;
+    // Serialize the recorded stages into JSON, to be aggregated by external tools.
+    std::string         to_json() const;
+
+private:
+    void                add_stage(Stage &&stage);
+
+    bool                m_enabled { false };
+    mutable std::mutex  m_mutex;
+    std::vector<Stage>  m_stages;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ProcessProfiler_hpp_
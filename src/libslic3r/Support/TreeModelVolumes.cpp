@@ -24,6 +24,7 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #include <tbb/task_group.h>
 
 namespace Slic3r::TreeSupport3D
@@ -154,6 +155,15 @@ TreeModelVolumes::TreeModelVolumes(
 #endif
 }
 
+// Estimate of the memory allocated by polygons, to account for the memory held by the caches.
+static size_t polygons_memsize(const Polygons &polygons)
+{
+    size_t out = sizeof(Polygon) * polygons.capacity();
+    for (const Polygon &polygon : polygons)
+        out += sizeof(Point) * polygon.points.capacity();
+    return out;
+}
+
 void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord_t max_layer, std::function<void()> throw_on_cancel)
 {
     auto t_start = std::chrono::high_resolution_clock::now();
@@ -240,7 +250,16 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
     auto t_coll = std::chrono::high_resolution_clock::now();
 
     // Calculate the relevant avoidances in parallel as far as possible
-    {
+    if (m_avoidance_memory_budget > 0) {
+        // Keeping every sqrt(n)-th layer of an avoidance minimizes the memory of the kept layers plus the layers recalculated between two of them.
+        m_checkpoint_interval = std::max<LayerIndex>(1, LayerIndex(std::round(std::sqrt(double(max_layer)))));
+        m_thin_avoidance      = true;
+        // Reservations of a cancelled calculation are not released.
+        m_avoidance_memory_reserved->store(0, std::memory_order_relaxed);
+        calculateAvoidance(relevant_avoidance_radiis, true, m_support_rests_on_model, throw_on_cancel);
+        m_thin_avoidance      = false;
+        // The wall restrictions are calculated on demand by the pathing.
+    } else {
         tbb::task_group task_group;
         task_group.run([this, relevant_avoidance_radiis, throw_on_cancel]{ calculateAvoidance(relevant_avoidance_radiis, true, m_support_rests_on_model, throw_on_cancel); });
         task_group.run([this, relevant_avoidance_radiis, throw_on_cancel]{ calculateWallRestrictions(relevant_avoidance_radiis, throw_on_cancel); });
@@ -252,6 +271,9 @@ void TreeModelVolumes::precalculate(const PrintObject& print_object, const coord
 
 //    m_precalculated = true;
     BOOST_LOG_TRIVIAL(info) << "Precalculating collision took" << dur_col << " ms. Precalculating avoidance took " << dur_avo << " ms.";
+    if (m_avoidance_memory_budget > 0)
+        BOOST_LOG_TRIVIAL(info) << "Avoidance cache holds " << this->avoidance_memory_used() << " bytes, peak " << this->avoidance_memory_peak() <<
+            " bytes, budget " << m_avoidance_memory_budget << " bytes, checkpoint interval " << m_checkpoint_interval << " layers.";
 
 #if 0
     // Paint caches into SVGs:
@@ -342,6 +364,19 @@ const Polygons& TreeModelVolumes::getAvoidance(const coord_t orig_radius, LayerI
         result)
         return (*result).get();
 
+    if (m_avoidance_memory_budget > 0) {
+        // Layers dropped by precalculate() or by the pathing, recalculate them from the closest layer below.
+        // The recalculation is isolated, so that this thread will not pick up another task waiting for m_recalculation_mutex while holding it.
+        std::lock_guard<std::mutex> lock(*m_recalculation_mutex);
+        if (! this->avoidance_cache(type, to_model).getArea({ radius, layer_idx }))
+            tbb::this_task_arena::isolate([this, radius, layer_idx, to_model]{
+                const_cast<TreeModelVolumes*>(this)->calculateAvoidance({ radius, layer_idx }, ! to_model, to_model); });
+        // Look the area up again without recursing, m_recalculation_mutex is not recursive.
+        if (std::optional<std::reference_wrapper<const Polygons>> result = this->avoidance_cache(type, to_model).getArea({ radius, layer_idx }); result)
+            return (*result).get();
+        tree_supports_show_error("Recalculation of a dropped Avoidance layer failed."sv, true);
+        throw Slic3r::RuntimeError(format("Tree support: failed to recalculate avoidance at radius %1% and layer %2%", radius, layer_idx));
+    }
     if (m_precalculated) {
         if (to_model) {
             BOOST_LOG_TRIVIAL(error_level_not_in_cache) << "Had to calculate Avoidance to model at radius " << radius << " and layer " << layer_idx << ", but precalculate was called. Performance may suffer!";
@@ -387,6 +422,18 @@ const Polygons& TreeModelVolumes::getWallRestriction(const coord_t orig_radius,
         (min_xy_dist ? m_wall_restrictions_cache_min : m_wall_restrictions_cache).getArea({ radius, layer_idx });
         result)
         return (*result).get();
+    if (m_avoidance_memory_budget > 0) {
+        std::lock_guard<std::mutex> lock(*m_recalculation_mutex);
+        const RadiusLayerPolygonCache &cache = min_xy_dist ? m_wall_restrictions_cache_min : m_wall_restrictions_cache;
+        if (! cache.getArea({ radius, layer_idx }))
+            tbb::this_task_arena::isolate([this, radius, layer_idx]{
+                const_cast<TreeModelVolumes*>(this)->calculateWallRestrictions({ radius, layer_idx }); });
+        // Look the area up again without recursing, m_recalculation_mutex is not recursive.
+        if (std::optional<std::reference_wrapper<const Polygons>> result = cache.getArea({ radius, layer_idx }); result)
+            return (*result).get();
+        tree_supports_show_error("Recalculation of a dropped Wall restriction layer failed."sv, true);
+        throw Slic3r::RuntimeError(format("Tree support: failed to recalculate wall restriction at radius %1% and layer %2%", radius, layer_idx));
+    }
     if (m_precalculated) {
         BOOST_LOG_TRIVIAL(error_level_not_in_cache) << "Had to calculate Wall restricions at radius " << radius << " and layer " << layer_idx << ", but precalculate was called. Performance may suffer!";
         tree_supports_show_error(
@@ -637,7 +684,8 @@ void TreeModelVolumes::calculateAvoidance(const std::vector<RadiusLayerPair> &ke
             ((iter_idx / 3) & 1) != 0  // to_model
         };
         // Ensure start_layer is at least 1 as if no avoidance was calculated yet getMaxCalculatedLayer() returns -1.
-        task.start_layer = std::max<LayerIndex>(1, 1 + avoidance_cache(task.type, task.to_model).getMaxCalculatedLayer(task.radius));
+        // Start above the highest layer calculated below max_required_layer, as layers may have been dropped due to m_avoidance_memory_budget.
+        task.start_layer = std::max<LayerIndex>(1, 1 + avoidance_cache(task.type, task.to_model).getMaxCalculatedLayer(task.radius, task.max_required_layer));
         if (task.start_layer > task.max_required_layer) {
             BOOST_LOG_TRIVIAL(debug) << "Calculation requested for value already calculated?";
             continue;
@@ -681,6 +729,7 @@ void TreeModelVolumes::calculateAvoidance(const std::vector<RadiusLayerPair> &ke
             Polygons    latest_avoidance   = getAvoidance(task.radius, task.start_layer - 1, task.type, task.to_model, true);
             std::vector<std::pair<RadiusLayerPair, Polygons>> data;
             data.reserve(task.max_required_layer + 1 - task.start_layer);
+            size_t data_memory = 0;
             for (LayerIndex layer_idx = task.start_layer; layer_idx <= task.max_required_layer; ++ layer_idx) {
                 // Merge current layer collisions with shrunk last_avoidance.
                 const Polygons &current_layer_collisions = collision_holefree ? getCollisionHolefree(task.radius, layer_idx) : getCollision(task.radius, layer_idx, true);
@@ -693,7 +742,21 @@ void TreeModelVolumes::calculateAvoidance(const std::vector<RadiusLayerPair> &ke
                 if (task.to_model)
                     latest_avoidance = diff(latest_avoidance, getPlaceableAreas(task.radius, layer_idx, throw_on_cancel));
                 latest_avoidance = polygons_simplify(latest_avoidance, m_min_resolution, polygons_strictly_simple);
-                data.emplace_back(RadiusLayerPair{task.radius, layer_idx}, latest_avoidance);
+                if (! m_thin_avoidance) {
+                    data.emplace_back(RadiusLayerPair{task.radius, layer_idx}, latest_avoidance);
+                } else {
+                    // The layers held by the other tasks running in parallel count against the budget as well, thus the layer is reserved
+                    // before it is kept. The checkpoints are always kept.
+                    const size_t memory   = polygons_memsize(latest_avoidance);
+                    const size_t reserved = m_avoidance_memory_reserved->fetch_add(memory) + memory;
+                    if (layer_idx == task.max_required_layer || layer_idx % m_checkpoint_interval == 0 ||
+                        this->avoidance_memory_used() + reserved <= m_avoidance_memory_budget) {
+                        data.emplace_back(RadiusLayerPair{task.radius, layer_idx}, latest_avoidance);
+                        data_memory += memory;
+                        this->update_avoidance_memory_peak();
+                    } else
+                        m_avoidance_memory_reserved->fetch_sub(memory);
+                }
                 if (throw_on_cancel)
                     throw_on_cancel();
             }
@@ -709,6 +772,9 @@ void TreeModelVolumes::calculateAvoidance(const std::vector<RadiusLayerPair> &ke
             }
 #endif
             avoidance_cache(task.type, task.to_model).insert(std::move(data));
+            if (m_thin_avoidance)
+                m_avoidance_memory_reserved->fetch_sub(data_memory);
+            this->update_avoidance_memory_peak();
         }
     });
 }
@@ -803,7 +869,9 @@ void TreeModelVolumes::calculateWallRestrictions(const std::vector<RadiusLayerPa
         for (size_t key_idx = range.begin(); key_idx < range.end(); ++ key_idx) {
             const coord_t    radius             = keys[key_idx].first;
             const LayerIndex max_required_layer = keys[key_idx].second;
-            const coord_t    min_layer_bottom   = std::max(1, m_wall_restrictions_cache.getMaxCalculatedLayer(radius));
+            // Limited to a window below max_required_layer if the wall restrictions are calculated on demand due to m_avoidance_memory_budget.
+            const coord_t    min_layer_bottom   = std::max({ 1, m_wall_restrictions_cache.getMaxCalculatedLayer(radius, max_required_layer), 
+                m_avoidance_memory_budget > 0 ? max_required_layer + 1 - m_checkpoint_interval : 0 });
             const size_t     buffer_size        = max_required_layer + 1 - min_layer_bottom;
             std::vector<Polygons> data(buffer_size, Polygons{});
             std::vector<Polygons> data_min;
@@ -828,6 +896,7 @@ void TreeModelVolumes::calculateWallRestrictions(const std::vector<RadiusLayerPa
             m_wall_restrictions_cache.insert(std::move(data), min_layer_bottom, radius);
             if (! data_min.empty())
                 m_wall_restrictions_cache_min.insert(std::move(data_min), min_layer_bottom, radius);
+            this->update_avoidance_memory_peak();
         }
     });
 }
@@ -861,12 +930,134 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
-void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
+size_t TreeModelVolumes::avoidance_memory_used() const
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    return m_avoidance_cache.memory_used() + m_avoidance_cache_slow.memory_used() + m_avoidance_cache_to_model.memory_used() + 
+        m_avoidance_cache_to_model_slow.memory_used() + m_avoidance_cache_holefree.memory_used() + m_avoidance_cache_holefree_to_model.memory_used() +
+        m_wall_restrictions_cache.memory_used() + m_wall_restrictions_cache_min.memory_used();
+}
+
+void TreeModelVolumes::update_avoidance_memory_peak() const
+{
+    const size_t used = this->avoidance_memory_used() + m_avoidance_memory_reserved->load(std::memory_order_relaxed);
+    for (size_t peak = m_avoidance_memory_peak->load(std::memory_order_relaxed);
+         used > peak && ! m_avoidance_memory_peak->compare_exchange_weak(peak, used, std::memory_order_relaxed);) ;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache& TreeModelVolumes::RadiusLayerPolygonCache::operator=(RadiusLayerPolygonCache &&rhs)
+{
+    if (this != &rhs) {
+        this->clear();
+        for (size_t i = 0; i < NUM_SEGMENTS; ++ i)
+            m_segments[i].store(rhs.m_segments[i].exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_memory_used.store(rhs.m_memory_used.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        m_num_layers.store(rhs.m_num_layers.exchange(0, std::memory_order_relaxed), std::memory_order_release);
+    }
+    return *this;
+}
+
+TreeModelVolumes::RadiusLayerPolygonCache::LayerData& TreeModelVolumes::RadiusLayerPolygonCache::get_allocate_layer_data(LayerIndex layer_idx)
+{
+    assert(layer_idx >= 0);
+    size_t     segment = segment_of_layer(size_t(layer_idx));
+    assert(segment < NUM_SEGMENTS);
+    LayerData *layers  = m_segments[segment].load(std::memory_order_acquire);
+    if (layers == nullptr) {
+        std::lock_guard<std::mutex> guard(m_segments_mutex);
+        layers = m_segments[segment].load(std::memory_order_relaxed);
+        if (layers == nullptr) {
+            layers = new LayerData[size_t(1) << segment];
+            m_segments[segment].store(layers, std::memory_order_release);
+        }
+    }
+    for (LayerIndex num_layers = m_num_layers.load(std::memory_order_relaxed); 
+         num_layers <= layer_idx && ! m_num_layers.compare_exchange_weak(num_layers, layer_idx + 1, std::memory_order_release, std::memory_order_relaxed);) ;
+    return layers[size_t(layer_idx) - first_layer_of_segment(segment)];
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons)
+{
+    LayerData                    &layer = this->get_allocate_layer_data(layer_idx);
+    tbb::spin_mutex::scoped_lock  lock(layer.mutex);
+    Entries                      *entries = layer.entries.load(std::memory_order_relaxed);
+    uint32_t                      size    = entries ? entries->size.load(std::memory_order_relaxed) : 0;
+    // The first area inserted for a radius wins, the same as with std::map::emplace().
+    for (uint32_t i = 0; i < size; ++ i)
+        if (entries->data[i].radius == radius)
+            return;
+    layer.polygons.emplace_back(std::move(polygons));
+    const Entry entry { radius, &layer.polygons.back() };
+    const size_t memory = polygons_memsize(layer.polygons.back());
+    layer.memory_used += memory;
+    m_memory_used.fetch_add(memory, std::memory_order_relaxed);
+    if (entries == nullptr || size == entries->capacity) {
+        // Publish a copy of the entries extended by the new one, the readers may still be scanning the old entries.
+        auto new_entries = std::make_unique<Entries>(std::max<uint32_t>(4, 2 * size));
+        if (size > 0)
+            std::copy(entries->data.get(), entries->data.get() + size, new_entries->data.get());
+        new_entries->data[size] = entry;
+        new_entries->size.store(size + 1, std::memory_order_relaxed);
+        layer.entries.store(new_entries.get(), std::memory_order_release);
+        layer.entries_storage.emplace_back(std::move(new_entries));
+    } else {
+        entries->data[size] = entry;
+        entries->size.store(size + 1, std::memory_order_release);
+    }
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_layers_from(LayerIndex first_layer_idx)
+{
+    first_layer_idx = std::max<LayerIndex>(0, first_layer_idx);
+    const LayerIndex num_layers = m_num_layers.load(std::memory_order_acquire);
+    for (size_t segment = 0; segment < NUM_SEGMENTS; ++ segment) {
+        LayerData *layers = m_segments[segment].load(std::memory_order_relaxed);
+        if (layers == nullptr)
+            continue;
+        size_t first = first_layer_of_segment(segment);
+        size_t last  = first_layer_of_segment(segment + 1);
+        if (first >= size_t(first_layer_idx)) {
+            // The whole segment is released.
+            for (size_t i = 0; i < last - first; ++ i)
+                m_memory_used.fetch_sub(layers[i].memory_used, std::memory_order_relaxed);
+            m_segments[segment].store(nullptr, std::memory_order_relaxed);
+            delete[] layers;
+        } else if (last > size_t(first_layer_idx)) {
+            for (size_t layer_idx = size_t(first_layer_idx); layer_idx < last; ++ layer_idx) {
+                LayerData &layer = layers[layer_idx - first];
+                m_memory_used.fetch_sub(layer.memory_used, std::memory_order_relaxed);
+                layer.memory_used = 0;
+                layer.entries.store(nullptr, std::memory_order_relaxed);
+                layer.entries_storage.clear();
+                layer.entries_storage.shrink_to_fit();
+                layer.polygons.clear();
+                layer.polygons.shrink_to_fit();
+            }
+        }
+    }
+    m_num_layers.store(std::min(num_layers, first_layer_idx), std::memory_order_release);
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    for (LayerIndex layer_idx = 0; layer_idx < m_num_layers.load(std::memory_order_acquire); ++ layer_idx) {
+        LayerData *layer   = this->layer(layer_idx);
+        Entries   *entries = layer ? layer->entries.load(std::memory_order_relaxed) : nullptr;
+        if (entries == nullptr || entries->size.load(std::memory_order_relaxed) < 2)
+            continue;
+        // Keep the area of the smallest radius.
+        const Entry *best = std::min_element(entries->data.get(), entries->data.get() + entries->size.load(std::memory_order_relaxed),
+            [](const Entry &l, const Entry &r) { return l.radius < r.radius; });
+        auto     it_polygons = std::find_if(layer->polygons.begin(), layer->polygons.end(), [best](const Polygons &p) { return &p == best->polygons; });
+        assert(it_polygons != layer->polygons.end());
+        Polygons polygons    = std::move(*it_polygons);
+        coord_t  radius      = best->radius;
+        m_memory_used.fetch_sub(layer->memory_used, std::memory_order_relaxed);
+        layer->memory_used = 0;
+        layer->entries.store(nullptr, std::memory_order_relaxed);
+        layer->entries_storage.clear();
+        layer->polygons.clear();
+        layer->polygons.shrink_to_fit();
+        this->insert(layer_idx, radius, std::move(polygons));
     }
 }
 
@@ -874,12 +1065,13 @@ void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layer
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
-    }
-    assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
+    for (LayerIndex layer_idx = 0; layer_idx < m_num_layers.load(std::memory_order_acquire); ++ layer_idx)
+        if (const Entries *entries = this->layer_entries(layer_idx); entries) {
+            size_t begin = out.size();
+            for (const Entry *it = entries->data.get(), *end = it + entries->size.load(std::memory_order_acquire); it != end; ++ it)
+                out.emplace_back(std::make_pair(it->radius, layer_idx), *it->polygons);
+            std::sort(out.begin() + begin, out.end(), [](auto &l, auto &r){ return l.first.first < r.first.first; });
+        }
     return out;
 }
 
@@ -9,11 +9,17 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <limits>
 #include <mutex>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
 
+#include <tbb/spin_mutex.h>
+
 #include "TreeSupportCommon.hpp"
 
 #include "../Point.hpp"
@@ -69,6 +75,30 @@ public:
         m_wall_restrictions_cache.clear();
         m_wall_restrictions_cache_min.clear();
     }
+    // Release the avoidances and wall restrictions from first_layer_idx up. Called by the top down pathing for the layers it has already passed,
+    // these areas are recalculated on demand if queried again.
+    void clear_avoidance_from_layer(LayerIndex first_layer_idx) {
+        m_avoidance_cache.clear_layers_from(first_layer_idx);
+        m_avoidance_cache_slow.clear_layers_from(first_layer_idx);
+        m_avoidance_cache_to_model.clear_layers_from(first_layer_idx);
+        m_avoidance_cache_to_model_slow.clear_layers_from(first_layer_idx);
+        m_avoidance_cache_holefree.clear_layers_from(first_layer_idx);
+        m_avoidance_cache_holefree_to_model.clear_layers_from(first_layer_idx);
+        m_wall_restrictions_cache.clear_layers_from(first_layer_idx);
+        m_wall_restrictions_cache_min.clear_layers_from(first_layer_idx);
+    }
+    // Cap of the memory held by the avoidance and wall restriction caches in bytes, 0 for no cap. Once the cap is reached by precalculate(),
+    // only every m_checkpoint_interval-th layer of an avoidance is kept and the layers in between are recalculated from the closest kept layer
+    // below when the top down pathing reaches them. The wall restrictions are then calculated on demand in windows of m_checkpoint_interval layers.
+    // The collision, hole free collision and placeable area caches are not bounded: their areas are referenced by the area drawing
+    // and the organic smoothing long after the pathing, thus they are kept for the whole support generation.
+    void set_avoidance_memory_budget(size_t bytes) { m_avoidance_memory_budget = bytes; }
+    size_t avoidance_memory_budget() const { return m_avoidance_memory_budget; }
+    // Memory held by the avoidance and wall restriction caches in bytes.
+    size_t avoidance_memory_used() const;
+    // Highest memory held by the avoidance and wall restriction caches so far in bytes, including the avoidance layers
+    // calculated by precalculate() and not yet inserted into the caches.
+    size_t avoidance_memory_peak() const { return m_avoidance_memory_peak->load(std::memory_order_relaxed); }
 
     enum class AvoidanceType : int8_t
     {
@@ -169,7 +199,7 @@ public:
 
     Polygon m_bed_area;
 
-private:
+    // The caches are public to be tested on their own.
     // Caching polygons for a range of layers.
     class LayerPolygonCache {
     public:
@@ -198,42 +228,63 @@ private:
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
     class RadiusLayerPolygonCache {
-        // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
-        // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        // Cache of one layer of areas for the radii calculated so far.
+        // The areas are stored in a flat array of (radius, area) entries published to the readers with a release store of its size,
+        // thus the lookups take no lock. Writers of a single layer are serialized by a spin lock of the layer, writers of different
+        // layers do not contend. The entries are never modified once published: if the array is full, it is copied into a larger one,
+        // which replaces it, while the old array is retired and kept alive for the readers still scanning it until the layer is cleared.
+        struct Entry {
+            coord_t         radius;
+            const Polygons *polygons;
+        };
+        struct Entries {
+            explicit Entries(uint32_t capacity) : data(new Entry[capacity]), capacity(capacity) {}
+            std::unique_ptr<Entry[]> data;
+            uint32_t                 capacity;
+            std::atomic<uint32_t>    size { 0 };
+        };
+        struct LayerData {
+            std::atomic<Entries*>                   entries { nullptr };
+            // The published entries are the last ones, the others were retired.
+            std::vector<std::unique_ptr<Entries>>   entries_storage;
+            // Stable to insertion.
+            std::deque<Polygons>                    polygons;
+            size_t                                  memory_used { 0 };
+            tbb::spin_mutex                         mutex;
+        };
+        // The layers are allocated in segments of exponentially growing size, segment i holding 2^i layers, which are never moved,
+        // thus a reference to LayerData and to its Polygons is stable to insertion and the readers access the layers without a lock.
+        static constexpr const size_t NUM_SEGMENTS = 32;
+        static size_t segment_of_layer(size_t layer_idx) { size_t i = 0; for (size_t n = layer_idx + 1; n > 1; n >>= 1) ++ i; return i; }
+        static size_t first_layer_of_segment(size_t segment) { return (size_t(1) << segment) - 1; }
+
     public:
         RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        ~RadiusLayerPolygonCache() { this->clear(); }
+        // Not thread safe.
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) { *this = std::move(rhs); }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs);
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->insert(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->insert(d.first, radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->insert(first_layer_idx ++, radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
-            allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->insert(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
@@ -241,71 +292,79 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
-                return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
-                std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
+            if (const Entries *entries = this->layer_entries(key.second); entries) {
+                for (const Entry *it = entries->data.get(), *end = it + entries->size.load(std::memory_order_acquire); it != end; ++ it)
+                    if (it->radius == key.first)
+                        return std::optional<std::reference_wrapper<const Polygons>>{ *it->polygons };
+            }
+            return std::optional<std::reference_wrapper<const Polygons>>{};
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
-                return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
-                return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
-                    return {};
-                -- it;
+            const Entry *best = nullptr;
+            if (const Entries *entries = this->layer_entries(key.second); entries) {
+                for (const Entry *it = entries->data.get(), *end = it + entries->size.load(std::memory_order_acquire); it != end; ++ it)
+                    if (it->radius <= key.first && (best == nullptr || it->radius > best->radius))
+                        best = it;
             }
-            return std::make_pair(it->first, std::reference_wrapper<const Polygons>(it->second));
+            if (best == nullptr)
+                return {};
+            return std::make_pair(best->radius, std::reference_wrapper<const Polygons>(*best->polygons));
         }
         /*!
          * \brief Get the highest already calculated layer in the cache.
          * \param radius The radius for which the highest already calculated layer has to be found.
          * \param map The cache in which the lookup is performed.
          *
+         * \param max_layer_idx Only the layers up to max_layer_idx are considered.
+         *
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
-        LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+        LayerIndex getMaxCalculatedLayer(coord_t radius, LayerIndex max_layer_idx = std::numeric_limits<LayerIndex>::max()) const {
+            auto layer_idx = std::min(m_num_layers.load(std::memory_order_acquire) - 1, max_layer_idx);
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
+                if (this->getArea({ radius, layer_idx }))
                     break;
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
-            return layer_idx == 0 ? -1 : layer_idx;
+            return layer_idx <= 0 ? -1 : layer_idx;
         }
 
+        // Estimate of the memory held by the cached areas in bytes.
+        size_t memory_used() const { return m_memory_used.load(std::memory_order_relaxed); }
+
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
-        }
+        // The following are not thread safe, no area returned by this cache may be referenced while they run.
+        void clear() { this->clear_layers_from(0); }
+        // Release the layers from first_layer_idx up, for example the layers the tree support pathing has already passed.
+        void clear_layers_from(LayerIndex first_layer_idx);
+        void clear_all_but_radius0();
 
     private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        void                insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons);
+        LayerData*          layer(LayerIndex layer_idx) const {
+            if (layer_idx < 0)
+                return nullptr;
+            size_t     segment = segment_of_layer(size_t(layer_idx));
+            LayerData *layers  = segment < NUM_SEGMENTS ? m_segments[segment].load(std::memory_order_acquire) : nullptr;
+            return layers ? layers + (size_t(layer_idx) - first_layer_of_segment(segment)) : nullptr;
         }
-        void                allocate_layers(size_t num_layers);
-
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+        const Entries*      layer_entries(LayerIndex layer_idx) const {
+            const LayerData *layer = this->layer(layer_idx);
+            return layer ? layer->entries.load(std::memory_order_acquire) : nullptr;
+        }
+        LayerData&          get_allocate_layer_data(LayerIndex layer_idx);
+
+        std::array<std::atomic<LayerData*>, NUM_SEGMENTS> m_segments {};
+        // One more than the highest layer inserted into, an upper bound of the populated layers.
+        std::atomic<LayerIndex>                          m_num_layers { 0 };
+        std::atomic<size_t>                              m_memory_used { 0 };
+        // Serializes the allocation of segments.
+        std::mutex                                       m_segments_mutex;
     };
 
+private:
 
     /*!
      * \brief Provides the areas that have to be avoided by the tree's branches to prevent collision with the model on this layer. Holes are removed.
@@ -545,6 +604,20 @@ private:
     // restriction would be slower.    
     RadiusLayerPolygonCache     m_wall_restrictions_cache_min;
 
+    // See set_avoidance_memory_budget().
+    size_t                      m_avoidance_memory_budget { 0 };
+    LayerIndex                  m_checkpoint_interval { 1 };
+    // Set while precalculate() calculates the avoidances, whose layers are thinned out to the checkpoints once m_avoidance_memory_budget is reached.
+    bool                        m_thin_avoidance { false };
+    // Memory of the avoidance layers held by the tasks of calculateAvoidance() running in parallel until they insert them into the caches.
+    // Reserved before a layer is kept, so that the tasks together stay within m_avoidance_memory_budget.
+    std::unique_ptr<std::atomic<size_t>> m_avoidance_memory_reserved { std::make_unique<std::atomic<size_t>>(0) };
+    // See avoidance_memory_peak().
+    std::unique_ptr<std::atomic<size_t>> m_avoidance_memory_peak { std::make_unique<std::atomic<size_t>>(0) };
+    void                        update_avoidance_memory_peak() const;
+    // Serializes the recalculation of the avoidances and wall restrictions dropped due to m_avoidance_memory_budget.
+    std::unique_ptr<std::mutex> m_recalculation_mutex { std::make_unique<std::mutex>() };
+
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
     std::unique_ptr<std::mutex> m_critical_progress { std::make_unique<std::mutex>() };
 #endif // SLIC3R_TREESUPPORTS_PROGRESS
@@ -2447,7 +2447,7 @@ static void merge_influence_areas(
  *
  * \param move_bounds[in,out] All currently existing influence areas
  */
-static void create_layer_pathing(const TreeModelVolumes &volumes, const TreeSupportSettings &config, std::vector<SupportElements> &move_bounds, std::function<void()> throw_on_cancel)
+static void create_layer_pathing(TreeModelVolumes &volumes, const TreeSupportSettings &config, std::vector<SupportElements> &move_bounds, std::function<void()> throw_on_cancel)
 {
 #ifdef SLIC3R_TREESUPPORTS_PROGRESS
     const double data_size_inverse = 1 / double(move_bounds.size());
@@ -2535,6 +2535,9 @@ static void create_layer_pathing(const TreeModelVolumes &volumes, const TreeSupp
                     this_layer.emplace_back(elem.state, std::move(elem.parents), std::move(new_area));
                 }
 
+            // The layers above layer_idx - 1 will not be queried by the pathing anymore.
+            volumes.clear_avoidance_from_layer(layer_idx);
+
     #ifdef SLIC3R_TREESUPPORTS_PROGRESS
             progress_total += data_size_inverse * TREE_PROGRESS_AREA_CALC;
             Progress::messageProgress(Progress::Stage::SUPPORT, progress_total * m_progress_multiplier + m_progress_offset, TREE_PROGRESS_TOTAL);
@@ -3383,6 +3386,7 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
             m_progress_multiplier, m_progress_offset,
 #endif // SLIC3R_TREESUPPORTS_PROGRESS
             /* additional_excluded_areas */{} };
+        volumes.set_avoidance_memory_budget(print.tree_support_avoidance_memory_budget());
 
         //FIXME generating overhangs just for the first mesh of the group.
         assert(processing.second.size() == 1);
@@ -3534,6 +3538,7 @@ static void generate_support_areas(Print &print, TreeSupport* tree_support, cons
     //            BOOST_LOG_TRIVIAL(error) << "Why ask questions when you already know the answer twice.\n (This is not a real bug, please dont report it.)";
             
             move_bounds.clear();
+            print_object.set_tree_support_avoidance_memory_peak(volumes.avoidance_memory_peak());
         } else if (generate_raft_contact(print_object, config, interface_placer) >= 0) {
             remove_undefined_layers();
         } else
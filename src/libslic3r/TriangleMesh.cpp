@@ -15,6 +15,7 @@
 #include <libqhullcpp/QhullFacetList.h>
 #include <libqhullcpp/QhullVertexSet.h>
 
+#include <atomic>
 #include <cmath>
 #include <deque>
 #include <queue>
@@ -24,9 +25,16 @@
 #include <type_traits>
 
 #include <boost/log/trivial.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/nowide/convert.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+
 #include <Eigen/Core>
 #include <Eigen/Dense>
 
@@ -48,7 +56,7 @@ static void fill_initial_stats(const indexed_triangle_set &its, TriangleMeshStat
     out.volume              = its_volume(its);
     update_bounding_box(its, out);
 
-    const std::vector<Vec3i32> face_neighbors = its_face_neighbors(its);
+    const std::vector<Vec3i32> face_neighbors = its_face_neighbors_par(its);
     out.number_of_parts = its_number_of_patches(its, face_neighbors);
     out.open_edges      = its_num_open_edges(face_neighbors);
 }
@@ -211,6 +219,22 @@ bool TriangleMesh::from_stl(stl_file& stl, bool repair)
 
 bool TriangleMesh::ReadSTLFile(const char *input_file, bool repair, ImportstlProgressFn stlFn, int custom_header_length)
 {
+    if (repair) {
+        // A well formed binary STL needs no repair, load it without materializing the admesh facets and neighbors.
+        switch (its_read_stl_binary_manifold(input_file, this->its, stlFn, custom_header_length)) {
+        case StlReadResult::Loaded:
+            m_stats.clear();
+            fill_initial_stats(this->its, m_stats);
+            return true;
+        case StlReadResult::Canceled:
+            this->clear();
+            return false;
+        case StlReadResult::Fallback:
+            this->clear();
+            break;
+        }
+    }
+
     stl_file stl;
     if (!stl_open(&stl, input_file, stlFn, custom_header_length))
         return false;
@@ -670,6 +694,18 @@ std::vector<Vec3i32> its_face_edge_ids(const indexed_triangle_set &its, std::vec
     return out;
 }
 
+// Replace the vertex indices of all faces through vertex_map, in parallel.
+static void its_remap_face_vertices(indexed_triangle_set &its, const std::vector<int> &vertex_map)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, its.indices.size()), [&its, &vertex_map](const tbb::blocked_range<size_t> &range) {
+        for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
+            stl_triangle_vertex_indices &face = its.indices[face_idx];
+            for (int i = 0; i < 3; ++ i)
+                face(i) = vertex_map[face(i)];
+        }
+    });
+}
+
 // Merge duplicate vertices, return number of vertices removed.
 int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
 {
@@ -677,7 +713,8 @@ int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
     auto sorted = reserve_vector<int>(its.vertices.size());
     for (int i = 0; i < int(its.vertices.size()); ++ i)
         sorted.emplace_back(i);
-    std::sort(sorted.begin(), sorted.end(), [&its](int il, int ir) {
+    // The order is total, thus the parallel sort produces the same result as a sequential one.
+    tbb::parallel_sort(sorted.begin(), sorted.end(), [&its](int il, int ir) {
         const Vec3f &l = its.vertices[il];
         const Vec3f &r = its.vertices[ir];
         // Sort lexicographically by coordinates AND vertex index.
@@ -722,9 +759,7 @@ int its_merge_vertices(indexed_triangle_set &its, bool shrink_to_fit)
         // Shrink the vertices.
         its.vertices.erase(its.vertices.begin() + k, its.vertices.end());
         // Remap face indices.
-        for (stl_triangle_vertex_indices &face : its.indices)
-            for (int i = 0; i < 3; ++ i)
-                face(i) = map_vertices[face(i)];
+        its_remap_face_vertices(its, map_vertices);
         // Optionally shrink to fit (reallocate) vertices.
         if (shrink_to_fit)
             its.vertices.shrink_to_fit();
@@ -741,9 +776,20 @@ void its_flip_triangles(indexed_triangle_set &its)
 
 int its_remove_degenerate_faces(indexed_triangle_set &its, bool shrink_to_fit)
 {
-    auto it = std::remove_if(its.indices.begin(), its.indices.end(), [](auto &face) {
+    auto is_degenerate = [](const stl_triangle_vertex_indices &face) {
         return face(0) == face(1) || face(0) == face(2) || face(1) == face(2);
-    });
+    };
+    // Most meshes have no degenerate faces, find out in parallel before compacting the faces sequentially.
+    bool has_degenerate = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, its.indices.size()), false,
+        [&its, &is_degenerate](const tbb::blocked_range<size_t> &range, bool found) {
+            for (size_t face_idx = range.begin(); ! found && face_idx < range.end(); ++ face_idx)
+                found = is_degenerate(its.indices[face_idx]);
+            return found;
+        }, std::logical_or<bool>());
+    if (! has_degenerate)
+        return 0;
+
+    auto it = std::remove_if(its.indices.begin(), its.indices.end(), is_degenerate);
 
     int removed = std::distance(it, its.indices.end());
     its.indices.erase(it, its.indices.end());
@@ -756,16 +802,18 @@ int its_remove_degenerate_faces(indexed_triangle_set &its, bool shrink_to_fit)
 
 int its_compactify_vertices(indexed_triangle_set &its, bool shrink_to_fit)
 {
-    // First used to mark referenced vertices, later used for mapping old vertex index to a new one.
+    // Mark referenced vertices in parallel. Concurrent threads only ever store 1, thus relaxed atomic stores suffice.
+    std::vector<std::atomic<char>> referenced(its.vertices.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, its.indices.size()), [&its, &referenced](const tbb::blocked_range<size_t> &range) {
+        for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx)
+            for (int i = 0; i < 3; ++ i)
+                referenced[its.indices[face_idx](i)].store(1, std::memory_order_relaxed);
+    });
+    // Compactify vertices, map old vertex index to a new one.
     std::vector<int> vertex_map(its.vertices.size(), 0);
-    // Mark referenced vertices.
-    for (const stl_triangle_vertex_indices &face : its.indices)
-        for (int i = 0; i < 3; ++ i)
-            vertex_map[face(i)] = 1;
-    // Compactify vertices, update map from old vertex index to a new one.
     int last = 0;
     for (int i = 0; i < int(vertex_map.size()); ++ i)
-        if (vertex_map[i]) {
+        if (referenced[i].load(std::memory_order_relaxed)) {
             if (last < i)
                 its.vertices[last] = its.vertices[i];
             vertex_map[i] = last ++;
@@ -774,9 +822,7 @@ int its_compactify_vertices(indexed_triangle_set &its, bool shrink_to_fit)
     if (removed) {
         its.vertices.erase(its.vertices.begin() + last, its.vertices.end());
         // Update faces with the new vertex indices.
-        for (stl_triangle_vertex_indices &face : its.indices)
-            for (int i = 0; i < 3; ++ i)
-                face(i) = vertex_map[face(i)];
+        its_remap_face_vertices(its, vertex_map);
         // Optionally shrink the vertices.
         if (shrink_to_fit)
             its.vertices.shrink_to_fit();
@@ -1656,4 +1702,161 @@ bool its_write_stl_binary(const char *file, const char *label, const std::vector
     return true;
 }
 
+static inline float stl_read_float(const char *p)
+{
+    float f;
+    ::memcpy(&f, p, 4);
+    big_endian_reverse_quads(reinterpret_cast<char*>(&f), 4);
+    return f;
+}
+
+StlReadResult its_read_stl_binary_manifold(const char *file, indexed_triangle_set &its, ImportstlProgressFn stlFn, int custom_header_length)
+{
+    its.clear();
+    if (custom_header_length < LABEL_SIZE)
+        custom_header_length = LABEL_SIZE;
+
+    boost::iostreams::mapped_file_source mapped;
+    try {
+#ifdef _WIN32
+        mapped.open(boost::nowide::widen(file));
+#else
+        mapped.open(file);
+#endif
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(debug) << "its_read_stl_binary_manifold: Couldn't map " << file << ": " << ex.what();
+        return StlReadResult::Fallback;
+    }
+    if (! mapped.is_open())
+        return StlReadResult::Fallback;
+
+    // Same binary / ASCII detection as stl_open(): a binary file contains a character above 127 in the first 128 bytes after the header.
+    const char   *data        = mapped.data();
+    const size_t  file_size   = mapped.size();
+    const size_t  header_size = size_t(custom_header_length) + NUM_FACET_SIZE;
+    if (file_size < STL_MIN_FILE_SIZE || file_size < header_size + 128 || (file_size - header_size) % SIZEOF_STL_FACET != 0 ||
+        std::none_of(data + header_size, data + header_size + 128, [](char c) { return (unsigned char)c > 127; }))
+        return StlReadResult::Fallback;
+    const size_t num_faces   = (file_size - header_size) / SIZEOF_STL_FACET;
+    const size_t num_corners = 3 * num_faces;
+    if (num_corners > size_t(std::numeric_limits<int>::max()))
+        return StlReadResult::Fallback;
+
+    // Coordinates of the i-th triangle corner, read from the mapped file. The 12 bytes of the facet normal are skipped.
+    auto corner = [data, header_size](size_t idx) -> stl_vertex {
+        const char *p = data + header_size + (idx / 3) * SIZEOF_STL_FACET + 12 * (idx % 3 + 1);
+        return { stl_read_float(p), stl_read_float(p + 4), stl_read_float(p + 8) };
+    };
+    // Lexicographic ordering of the corners, -0.f equals 0.f as in the exact matching of admesh.
+    auto corner_lower = [&corner](uint32_t lhs, uint32_t rhs) {
+        stl_vertex a = corner(lhs), b = corner(rhs);
+        return a.x() < b.x() || (a.x() == b.x() && (a.y() < b.y() || (a.y() == b.y() && a.z() < b.z())));
+    };
+    constexpr size_t num_steps = 4;
+    auto canceled = [&stlFn, num_faces](size_t step) {
+        bool cancel = false;
+        if (stlFn) {
+            std::string model_id, country_code;
+            stlFn(int(step * num_faces / num_steps), int(num_faces), cancel, model_id, country_code);
+        }
+        return cancel;
+    };
+
+    // Facets with NaN coordinates are dropped by admesh. Let admesh handle them, NaNs would also break the corner ordering.
+    if (canceled(0))
+        return StlReadResult::Canceled;
+    std::atomic<bool> failed { false };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_corners), [&corner, &failed](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end() && ! failed.load(std::memory_order_relaxed); ++ i)
+            if (stl_vertex v = corner(i); std::isnan(v.x()) || std::isnan(v.y()) || std::isnan(v.z()))
+                failed = true;
+    });
+    if (failed)
+        return StlReadResult::Fallback;
+
+    // Weld the vertices by sorting the corners. Each corner is mapped to the lowest corner index of its equal corners,
+    // the corner indices are stored into its.indices temporarily.
+    if (canceled(1))
+        return StlReadResult::Canceled;
+    its.indices.assign(num_faces, stl_triangle_vertex_indices::Zero());
+    std::atomic<size_t> num_vertices { 0 };
+    {
+        std::vector<uint32_t> order(num_corners);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_corners), [&order](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                order[i] = uint32_t(i);
+        });
+        tbb::parallel_sort(order.begin(), order.end(), corner_lower);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_corners), [&its, &order, &corner, &num_vertices](const tbb::blocked_range<size_t> &range) {
+            // A group of equal corners crossing the range boundary is processed by the range containing its first corner.
+            size_t i = range.begin();
+            while (i > 0 && i < range.end() && corner(order[i]) == corner(order[i - 1]))
+                ++ i;
+            size_t num_groups = 0;
+            while (i < range.end()) {
+                stl_vertex v      = corner(order[i]);
+                uint32_t   leader = order[i];
+                size_t     j      = i + 1;
+                for (; j < order.size() && corner(order[j]) == v; ++ j)
+                    leader = std::min(leader, order[j]);
+                for (; i < j; ++ i)
+                    its.indices[order[i] / 3](order[i] % 3) = int(leader);
+                ++ num_groups;
+            }
+            num_vertices += num_groups;
+        });
+    }
+
+    // Number the vertices in the order of their first occurence in the file, as stl_generate_shared_vertices() does.
+    if (canceled(2))
+        return StlReadResult::Canceled;
+    its.vertices.reserve(num_vertices);
+    for (size_t i = 0; i < num_corners; ++ i) {
+        int &idx = its.indices[i / 3](i % 3);
+        if (size_t(idx) == i) {
+            idx = int(its.vertices.size());
+            its.vertices.emplace_back(corner(i));
+        } else
+            // The leader has a lower index, thus it has already been numbered.
+            idx = its.indices[idx / 3](idx % 3);
+    }
+    assert(its.vertices.size() == num_vertices);
+
+    // The mesh is a closed, consistently oriented manifold if each directed edge is unique and its reverse edge exists.
+    if (canceled(3))
+        return StlReadResult::Canceled;
+    {
+        // 8 bytes per corner, the largest temporary of the loader: the corner order above needs only 4 bytes per corner.
+        std::vector<uint64_t> edges(num_corners);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_faces), [&its, &edges, &failed](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i) {
+                const stl_triangle_vertex_indices &face = its.indices[i];
+                if (face(0) == face(1) || face(1) == face(2) || face(2) == face(0))
+                    // Degenerate face.
+                    failed = true;
+                for (int j = 0; j < 3; ++ j)
+                    edges[3 * i + j] = (uint64_t(uint32_t(face(j))) << 32) | uint32_t(face(j < 2 ? j + 1 : 0));
+            }
+        });
+        if (failed) {
+            its.clear();
+            return StlReadResult::Fallback;
+        }
+        tbb::parallel_sort(edges.begin(), edges.end());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, num_corners), [&edges, &failed](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end() && ! failed.load(std::memory_order_relaxed); ++ i) {
+                uint64_t edge = edges[i];
+                if ((i + 1 < edges.size() && edges[i + 1] == edge) || ! std::binary_search(edges.begin(), edges.end(), (edge << 32) | (edge >> 32)))
+                    failed = true;
+            }
+        });
+    }
+    // admesh would flip all the faces of a mesh with a negative volume.
+    if (failed || its_volume(its) < 0) {
+        its.clear();
+        return StlReadResult::Fallback;
+    }
+    return StlReadResult::Loaded;
+}
+
 } // namespace Slic3r
@@ -151,6 +151,7 @@ public:
     void   restore_optional() {}
 
     const TriangleMeshStats& stats() const { return m_stats; }
+    void set_repaired_errors(const RepairedMeshErrors &errors) { m_stats.repaired_errors = errors; }
 
     void set_init_shift(const Vec3d &offset) { m_init_shift = offset; }
     Vec3d get_init_shift() const { return m_init_shift; }
@@ -361,6 +362,17 @@ inline bool its_write_stl_ascii(const char *file, const char *label, const index
 bool        its_write_stl_binary(const char *file, const char *label, const std::vector<stl_triangle_vertex_indices> &indices, const std::vector<stl_vertex> &vertices);
 inline bool its_write_stl_binary(const char *file, const char *label, const indexed_triangle_set &its) { return its_write_stl_binary(file, label, its.indices, its.vertices); }
 
+enum class StlReadResult {
+    Loaded,
+    // The file is not a binary STL or the mesh needs to be repaired, it shall be loaded through admesh.
+    Fallback,
+    Canceled,
+};
+// Load a binary STL into an indexed triangle set directly, welding the vertices of exactly equal coordinates.
+// The file is memory mapped and the vertices are welded in parallel. Only a closed, consistently oriented
+// manifold mesh with a positive volume is accepted, as such a mesh would not be modified by the admesh repair.
+StlReadResult its_read_stl_binary_manifold(const char *file, indexed_triangle_set &its, ImportstlProgressFn stlFn = nullptr, int custom_header_length = 80);
+
 inline BoundingBoxf3 bounding_box(const TriangleMesh &m) { return m.bounding_box(); }
 inline BoundingBoxf3 bounding_box(const indexed_triangle_set& its)
 {
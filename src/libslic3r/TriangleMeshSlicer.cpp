@@ -17,6 +17,7 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 #ifndef NDEBUG
 //    #define EXPENSIVE_DEBUG_CHECKS
@@ -472,41 +473,106 @@ static FacetSliceType slice_facet_for_cut_mesh(
     return FacetSliceType::NoSlice;
 }
 
-template<typename TransformVertex>
-void slice_facet_at_zs(
-    // Scaled or unscaled vertices. transform_vertex_fn may scale zs.
-    const std::vector<Vec3f>                         &mesh_vertices,
-    const TransformVertex                            &transform_vertex_fn,
-    const stl_triangle_vertex_indices                &indices,
-    const Vec3i32                                      &edge_ids,
-    // Scaled or unscaled zs. If vertices have their zs scaled or transform_vertex_fn scales them, then zs have to be scaled as well.
-    const std::vector<float>                         &zs,
-    std::vector<IntersectionLines>                   &lines,
-    std::array<std::mutex, 64>                       &lines_mutex)
+// Range of layers [first, second) cut by a facet given by the Z coordinates of its vertices.
+static inline std::pair<size_t, size_t> facet_layer_range(const float min_z, const float max_z, const std::vector<float> &zs)
 {
-    stl_vertex vertices[3] { transform_vertex_fn(mesh_vertices[indices(0)]), transform_vertex_fn(mesh_vertices[indices(1)]), transform_vertex_fn(mesh_vertices[indices(2)]) };
-
-    // find facet extents
-    const float min_z = fminf(vertices[0].z(), fminf(vertices[1].z(), vertices[2].z()));
-    const float max_z = fmaxf(vertices[0].z(), fmaxf(vertices[1].z(), vertices[2].z()));
-
-    // find layer extents
     auto min_layer = std::lower_bound(zs.begin(), zs.end(), min_z); // first layer whose slice_z is >= min_z
     auto max_layer = std::upper_bound(min_layer, zs.end(), max_z); // first layer whose slice_z is > max_z
-    int  idx_vertex_lowest = (vertices[1].z() == min_z) ? 1 : ((vertices[2].z() == min_z) ? 2 : 0);
+    return { size_t(min_layer - zs.begin()), size_t(max_layer - zs.begin()) };
+}
 
-    for (auto it = min_layer; it != max_layer; ++ it) {
+// Edge of a facet prepared for intersecting with a sequence of slicing planes in a general position,
+// with the end points ordered and the differences of their coordinates precalculated the same way slice_facet() does.
+struct SlicingFacetEdge
+{
+    int    edge_id;
+    float  min_z;
+    float  max_z;
+    double bx, by, bz;
+    double dx, dy, dz;
+};
+
+// Intersect a facet with the slicing planes zs[layer_begin, layer_end), producing the same lines as calling slice_facet() for each plane.
+// Most of the planes cut a facet of a finely sliced mesh in a general position, that is at two edges and not through a vertex.
+// For these planes the intersection points are calculated in a tight loop over the planes with the edges prepared once,
+// the few planes passing through a vertex are handed over to slice_facet().
+static void slice_facet_at_zs(
+    const stl_vertex                    *vertices,
+    const stl_triangle_vertex_indices   &indices,
+    const Vec3i32                       &edge_ids,
+    const int                            idx_vertex_lowest,
+    const std::vector<float>            &zs,
+    const size_t                         layer_begin,
+    const size_t                         layer_end,
+    std::vector<IntersectionLines>      &lines)
+{
+    // Edges in the order slice_facet() visits them.
+    SlicingFacetEdge edges[3];
+    for (int j = 0; j < 3; ++ j) {
+        int k = (idx_vertex_lowest + j) % 3;
+        int l = (k + 1) % 3;
+        const stl_vertex *a = vertices + k;
+        const stl_vertex *b = vertices + l;
+        // Sort the edge to give a consistent answer.
+        if (indices[k] > indices[l])
+            std::swap(a, b);
+        SlicingFacetEdge &edge = edges[j];
+        edge.edge_id = edge_ids(k);
+        edge.min_z   = std::min(a->z(), b->z());
+        edge.max_z   = std::max(a->z(), b->z());
+        edge.bx      = double(b->x());
+        edge.by      = double(b->y());
+        edge.bz      = double(b->z());
+        edge.dx      = double(a->x()) - double(b->x());
+        edge.dy      = double(a->y()) - double(b->y());
+        edge.dz      = double(a->z()) - double(b->z());
+    }
+
+    for (size_t slice_id = layer_begin; slice_id < layer_end; ++ slice_id) {
+        const float slice_z = zs[slice_id];
         IntersectionLine il;
-        // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-        if (min_z != max_z && slice_facet(*it, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
+        bool general = slice_z != vertices[0].z() && slice_z != vertices[1].z() && slice_z != vertices[2].z();
+        if (general) {
+            IntersectionPoint points[3];
+            size_t            num_points = 0;
+            for (const SlicingFacetEdge &edge : edges)
+                if (edge.min_z < slice_z && slice_z < edge.max_z) {
+                    double t = (double(slice_z) - edge.bz) / edge.dz;
+                    if (t <= 0. || t >= 1.) {
+                        // Snapped to a vertex due to rounding, let slice_facet() resolve it.
+                        general = false;
+                        break;
+                    }
+                    IntersectionPoint &point = points[num_points ++];
+                    point.x()     = coord_t(floor(edge.bx + edge.dx * t + 0.5));
+                    point.y()     = coord_t(floor(edge.by + edge.dy * t + 0.5));
+                    point.edge_id = edge.edge_id;
+                }
+            if (general) {
+                assert(num_points == 0 || num_points == 2);
+                if (num_points == 2) {
+                    il.edge_type = IntersectionLine::FacetEdgeType::General;
+                    il.a         = static_cast<const Point&>(points[1]);
+                    il.b         = static_cast<const Point&>(points[0]);
+                    il.edge_a_id = points[1].edge_id;
+                    il.edge_b_id = points[0].edge_id;
+                    lines[slice_id].emplace_back(il);
+                }
+                continue;
+            }
+        }
+        if (slice_facet(slice_z, vertices, indices, edge_ids, idx_vertex_lowest, false, il) == FacetSliceType::Slicing) {
             assert(il.edge_type != IntersectionLine::FacetEdgeType::Horizontal);
-            size_t slice_id = it - zs.begin();
-            boost::lock_guard<std::mutex> l(lines_mutex[slice_id % lines_mutex.size()]);
             lines[slice_id].emplace_back(il);
         }
     }
 }
 
+// Slicing is done in two passes: First the facets are bucketed into bands of consecutive layers by the range of layers they cut,
+// then the bands are sliced in parallel. Each band owns the IntersectionLines of its layers, thus no locking is needed,
+// and the lines of a layer are ordered by the facet index, thus the result does not depend on the scheduling of the threads.
+// The Z coordinates of the vertices are extracted into a contiguous array first, so that the first pass
+// calculating the Z extents of the facets touches 4 bytes per vertex instead of a whole transformed vertex.
 template<typename TransformVertex, typename ThrowOnCancel>
 static inline std::vector<IntersectionLines> slice_make_lines(
     const std::vector<stl_vertex>                   &vertices,
@@ -517,17 +583,80 @@ static inline std::vector<IntersectionLines> slice_make_lines(
     const ThrowOnCancel                              throw_on_cancel_fn)
 {
     std::vector<IntersectionLines>  lines(zs.size(), IntersectionLines());
-    std::array<std::mutex, 64>      lines_mutex;
+    if (zs.empty() || indices.empty())
+        return lines;
+
+    std::vector<float> vertex_z(vertices.size());
     tbb::parallel_for(
-        tbb::blocked_range<int>(0, int(indices.size())),
-        [&vertices, &transform_vertex_fn, &indices, &face_edge_ids, &zs, &lines, &lines_mutex, throw_on_cancel_fn](const tbb::blocked_range<int> &range) {
-            for (int face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
+        tbb::blocked_range<size_t>(0, vertices.size()),
+        [&vertices, &transform_vertex_fn, &vertex_z](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                vertex_z[i] = transform_vertex_fn(vertices[i]).z();
+        });
+    throw_on_cancel_fn();
+
+    // Several bands per thread to balance the load, as the facets are usually not distributed evenly along Z.
+    const size_t num_bands = std::min(zs.size(), size_t(8 * std::max(1, tbb::this_task_arena::max_concurrency())));
+    auto         band_of_layer = [num_bands, num_layers = zs.size()](size_t layer) { return layer * num_bands / num_layers; };
+    auto         first_layer_of_band = [num_bands, num_layers = zs.size()](size_t band) { return (band * num_layers + num_bands - 1) / num_bands; };
+
+    // Range of layers [first, second) cut by each facet, empty for facets not cut by any layer and for horizontal facets.
+    // Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
+    std::vector<std::pair<uint32_t, uint32_t>> facet_layers(indices.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, indices.size()),
+        [&vertex_z, &indices, &zs, &facet_layers, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t face_idx = range.begin(); face_idx < range.end(); ++ face_idx) {
                 if ((face_idx & 0x0ffff) == 0)
                     throw_on_cancel_fn();
-                slice_facet_at_zs(vertices, transform_vertex_fn, indices[face_idx], face_edge_ids[face_idx], zs, lines, lines_mutex);
+                const stl_triangle_vertex_indices &face = indices[face_idx];
+                const float z0 = vertex_z[face(0)];
+                const float z1 = vertex_z[face(1)];
+                const float z2 = vertex_z[face(2)];
+                const float min_z = fminf(z0, fminf(z1, z2));
+                const float max_z = fmaxf(z0, fmaxf(z1, z2));
+                auto [min_layer, max_layer] = min_z == max_z ? std::make_pair(size_t(0), size_t(0)) : facet_layer_range(min_z, max_z, zs);
+                facet_layers[face_idx] = std::make_pair(uint32_t(min_layer), uint32_t(max_layer));
             }
-        }
-    );
+        });
+
+    // Facets of each band sorted by the facet index, stored in a compressed row format.
+    std::vector<size_t> band_facets_begin(num_bands + 1, 0);
+    for (const std::pair<uint32_t, uint32_t> &layers : facet_layers)
+        if (layers.first < layers.second)
+            for (size_t band = band_of_layer(layers.first); band <= band_of_layer(layers.second - 1); ++ band)
+                ++ band_facets_begin[band + 1];
+    for (size_t band = 0; band < num_bands; ++ band)
+        band_facets_begin[band + 1] += band_facets_begin[band];
+    std::vector<uint32_t> band_facets(band_facets_begin.back());
+    {
+        std::vector<size_t> band_facets_end(band_facets_begin.begin(), band_facets_begin.end() - 1);
+        for (uint32_t face_idx = 0; face_idx < uint32_t(facet_layers.size()); ++ face_idx)
+            if (const std::pair<uint32_t, uint32_t> &layers = facet_layers[face_idx]; layers.first < layers.second)
+                for (size_t band = band_of_layer(layers.first); band <= band_of_layer(layers.second - 1); ++ band)
+                    band_facets[band_facets_end[band] ++] = face_idx;
+    }
+    throw_on_cancel_fn();
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_bands, 1),
+        [&vertices, &transform_vertex_fn, &vertex_z, &indices, &face_edge_ids, &zs, &lines, &facet_layers, &band_facets, &band_facets_begin, &first_layer_of_band, throw_on_cancel_fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t band = range.begin(); band < range.end(); ++ band) {
+                const size_t layer_begin = first_layer_of_band(band);
+                const size_t layer_end   = first_layer_of_band(band + 1);
+                for (size_t i = band_facets_begin[band]; i < band_facets_begin[band + 1]; ++ i) {
+                    if ((i & 0x0ffff) == 0)
+                        throw_on_cancel_fn();
+                    const uint32_t                     face_idx = band_facets[i];
+                    const stl_triangle_vertex_indices &face     = indices[face_idx];
+                    const stl_vertex facet_vertices[3] { transform_vertex_fn(vertices[face(0)]), transform_vertex_fn(vertices[face(1)]), transform_vertex_fn(vertices[face(2)]) };
+                    const float min_z = fminf(vertex_z[face(0)], fminf(vertex_z[face(1)], vertex_z[face(2)]));
+                    const int   idx_vertex_lowest = (vertex_z[face(1)] == min_z) ? 1 : ((vertex_z[face(2)] == min_z) ? 2 : 0);
+                    slice_facet_at_zs(facet_vertices, face, face_edge_ids[face_idx], idx_vertex_lowest, zs,
+                        std::max<size_t>(facet_layers[face_idx].first, layer_begin), std::min<size_t>(facet_layers[face_idx].second, layer_end), lines);
+                }
+            }
+        });
     return lines;
 }
 
@@ -1841,22 +1970,37 @@ static std::vector<stl_vertex> transform_mesh_vertices_for_slicing(const indexed
 {
     // Copy and scale vertices in XY, don't scale in Z.
     // Possibly apply the transformation.
-    const double   s = 1. / SCALING_FACTOR;
-    std::vector<stl_vertex>         out(mesh.vertices);
+    // The coefficients of the transformation are held in scalars and the vertices are processed as a flat array of floats,
+    // so that the compiler vectorizes the loop instead of multiplying an unaligned Vec3f by a matrix one vertex at a time.
+    static_assert(sizeof(stl_vertex) == 3 * sizeof(float), "stl_vertex is expected to be a packed triplet of floats");
+    const double            s = 1. / SCALING_FACTOR;
+    std::vector<stl_vertex> out(mesh.vertices.size());
+    const float            *src = mesh.vertices.empty() ? nullptr : mesh.vertices.front().data();
+    float                  *dst = out.empty() ? nullptr : out.front().data();
     if (is_identity(trafo)) {
-        // Identity.
-        for (stl_vertex &v : out) {
-            // Scale just XY, leave Z unscaled.
-            v.x() *= float(s);
-            v.y() *= float(s);
-        }
+        // Identity. Scale just XY, leave Z unscaled.
+        const float sf = float(s);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, out.size()), [src, dst, sf](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = 3 * range.begin(); i < 3 * range.end(); i += 3) {
+                dst[i]     = src[i] * sf;
+                dst[i + 1] = src[i + 1] * sf;
+                dst[i + 2] = src[i + 2];
+            }
+        });
     } else {
-        // Transform the vertices, scale up in XY, not in Y.
-        auto t = trafo;
-        t.prescale(Vec3d(s, s, 1.));
-        auto tf = t.cast<float>();
-        for (stl_vertex &v : out)
-            v = tf * v;
+        // Transform the vertices, scale up in XY, not in Z.
+        const Transform3f tf = make_trafo_for_slicing(trafo);
+        const float m00 = tf(0, 0), m01 = tf(0, 1), m02 = tf(0, 2), t0 = tf(0, 3);
+        const float m10 = tf(1, 0), m11 = tf(1, 1), m12 = tf(1, 2), t1 = tf(1, 3);
+        const float m20 = tf(2, 0), m21 = tf(2, 1), m22 = tf(2, 2), t2 = tf(2, 3);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, out.size()), [=](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = 3 * range.begin(); i < 3 * range.end(); i += 3) {
+                const float x = src[i], y = src[i + 1], z = src[i + 2];
+                dst[i]     = m00 * x + m01 * y + m02 * z + t0;
+                dst[i + 1] = m10 * x + m11 * y + m12 * z + t1;
+                dst[i + 2] = m20 * x + m21 * y + m22 * z + t2;
+            }
+        });
     }
     return out;
 }
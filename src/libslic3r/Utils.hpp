@@ -93,6 +93,12 @@ extern std::string log_memory_info(bool ignore_loglevel = false);
 extern void disable_multi_threading();
 // Returns the size of physical memory (RAM) in bytes.
 extern size_t total_physical_memory();
+// Returns the peak resident memory of the current process in bytes, 0 if not available.
+extern size_t peak_memory_usage();
+// Returns the current resident memory of the current process in bytes, 0 if not available.
+extern size_t current_memory_usage();
+// Returns the CPU time (user + system) consumed by all threads of the current process in seconds.
+extern double process_cpu_time();
 
 // Set a path with GUI resource files.
 void set_var_dir(const std::string &path);
@@ -104,7 +104,7 @@ void Zipper::add_entry(const std::string &name, const void *data, size_t l)
     case TIGHT_COMPRESSION: cmpr = MZ_BEST_COMPRESSION; break;
     }
 
-    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
+    if(!zip_writer_add_mem_parallel(&m_impl->arch, name.c_str(), data, l, cmpr))
         m_impl->blow_up();
 
     m_entry.clear();
@@ -124,10 +124,10 @@ void Zipper::finish_entry()
         case TIGHT_COMPRESSION: compression = MZ_BEST_COMPRESSION; break;
         }
 
-        if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
-                                  m_data.c_str(),
-                                  m_data.size(),
-                                  compression)) m_impl->blow_up();
+        if(!zip_writer_add_mem_parallel(&m_impl->arch, m_entry.c_str(),
+                                        m_data.c_str(),
+                                        m_data.size(),
+                                        compression)) m_impl->blow_up();
     }
 
     m_data.clear();
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <exception>
+#include <vector>
 
 #include "miniz_extension.hpp"
 
@@ -8,6 +10,8 @@
 
 #include "I18N.hpp"
 
+#include <tbb/parallel_for.h>
+
 //! macro used to mark string used at localization,
 //! return same string
 #define L(s) Slic3r::I18N::translate(s)
@@ -76,6 +80,129 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname)
 bool close_zip_reader(mz_zip_archive *zip) { return close_zip(zip, true); }
 bool close_zip_writer(mz_zip_archive *zip) { return close_zip(zip, false); }
 
+namespace {
+// Size of a chunk compressed by a single thread. Large enough for the compression ratio not to suffer much
+// from restarting the dictionary at the start of each chunk.
+constexpr size_t PARALLEL_DEFLATE_CHUNK = 1024 * 1024;
+
+// Multiply the 32x32 matrix over GF(2) by a vector, see crc32_combine() of zlib.
+mz_uint32 gf2_matrix_times(const mz_uint32 *mat, mz_uint32 vec)
+{
+    mz_uint32 sum = 0;
+    for (; vec; vec >>= 1, ++ mat)
+        if (vec & 1)
+            sum ^= *mat;
+    return sum;
+}
+
+void gf2_matrix_square(mz_uint32 *square, const mz_uint32 *mat)
+{
+    for (int n = 0; n < 32; ++ n)
+        square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+// CRC-32 of the concatenation of two blocks given the CRC-32 of both blocks and the length of the second one.
+// Port of crc32_combine() of zlib, which miniz does not provide.
+mz_uint32 crc32_combine(mz_uint32 crc1, mz_uint32 crc2, size_t len2)
+{
+    if (len2 == 0)
+        return crc1;
+
+    mz_uint32 even[32]; // even-power-of-two zeros operator
+    mz_uint32 odd[32];  // odd-power-of-two zeros operator
+
+    // Operator for one zero bit in odd.
+    odd[0] = 0xedb88320u;
+    for (int n = 1, row = 1; n < 32; ++ n, row <<= 1)
+        odd[n] = mz_uint32(row);
+    // Operator for two zero bits in even, for four zero bits in odd.
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // Apply len2 zeros to crc1, the first square puts the operator for one zero byte (eight zero bits) in even.
+    do {
+        gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(even, crc1);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(odd, crc1);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+mz_bool append_to_vector(const void *buf, int len, void *user)
+{
+    auto *out = static_cast<std::vector<unsigned char>*>(user);
+    out->insert(out->end(), static_cast<const unsigned char*>(buf), static_cast<const unsigned char*>(buf) + len);
+    return MZ_TRUE;
+}
+}
+
+bool zip_writer_add_mem_parallel(mz_zip_archive *zip, const char *archive_name, const void *buf, size_t buf_size, mz_uint level_and_flags)
+{
+    // MZ_DEFAULT_COMPRESSION is mz_uint(-1), which would set all the flag bits when composed with MZ_ZIP_FLAG_COMPRESSED_DATA below.
+    if ((int)level_and_flags < 0)
+        level_and_flags = MZ_DEFAULT_LEVEL;
+    const int level = int(level_and_flags & 0xF);
+    if (level == 0 || buf_size < 2 * PARALLEL_DEFLATE_CHUNK)
+        return mz_zip_writer_add_mem(zip, archive_name, buf, buf_size, level_and_flags);
+
+    struct Chunk {
+        std::vector<unsigned char> data;
+        mz_uint32                  crc { 0 };
+        bool                       ok { false };
+    };
+    const size_t       num_chunks = (buf_size + PARALLEL_DEFLATE_CHUNK - 1) / PARALLEL_DEFLATE_CHUNK;
+    std::vector<Chunk> chunks(num_chunks);
+    const mz_uint      comp_flags = tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY);
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_chunks), [&](const tbb::blocked_range<size_t> &range) {
+        tdefl_compressor *comp = tdefl_compressor_alloc();
+        if (comp == nullptr)
+            return;
+        for (size_t i = range.begin(); i < range.end(); ++ i) {
+            const unsigned char *src  = static_cast<const unsigned char*>(buf) + i * PARALLEL_DEFLATE_CHUNK;
+            size_t               size = std::min(PARALLEL_DEFLATE_CHUNK, buf_size - i * PARALLEL_DEFLATE_CHUNK);
+            Chunk               &chunk = chunks[i];
+            chunk.data.reserve(size / 2);
+            chunk.crc = (mz_uint32)mz_crc32(MZ_CRC32_INIT, src, size);
+            // All but the last chunk end with a sync flush, which emits a non-final block aligned to a byte boundary.
+            chunk.ok  = tdefl_init(comp, append_to_vector, &chunk.data, comp_flags) == TDEFL_STATUS_OKAY &&
+                        tdefl_compress_buffer(comp, src, size, i + 1 == num_chunks ? TDEFL_FINISH : TDEFL_SYNC_FLUSH) ==
+                            (i + 1 == num_chunks ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+        }
+        tdefl_compressor_free(comp);
+    });
+
+    size_t    compressed_size = 0;
+    mz_uint32 crc             = (mz_uint32)MZ_CRC32_INIT;
+    for (size_t i = 0; i < num_chunks; ++ i) {
+        if (! chunks[i].ok) {
+            zip->m_last_error = MZ_ZIP_COMPRESSION_FAILED;
+            return false;
+        }
+        compressed_size += chunks[i].data.size();
+        crc = crc32_combine(crc, chunks[i].crc, std::min(PARALLEL_DEFLATE_CHUNK, buf_size - i * PARALLEL_DEFLATE_CHUNK));
+    }
+
+    std::vector<unsigned char> compressed;
+    compressed.reserve(compressed_size);
+    for (Chunk &chunk : chunks) {
+        compressed.insert(compressed.end(), chunk.data.begin(), chunk.data.end());
+        std::vector<unsigned char>().swap(chunk.data);
+    }
+
+    return mz_zip_writer_add_mem_ex_v2(zip, archive_name, compressed.data(), compressed.size(), nullptr, 0,
+                                       mz_uint(level) | (level_and_flags & ~0xFu) | MZ_ZIP_FLAG_COMPRESSED_DATA,
+                                       buf_size, crc, nullptr, nullptr, 0, nullptr, 0);
+}
+
 MZ_Archive::MZ_Archive()
 {
     mz_zip_zero_struct(&arch);
@@ -11,6 +11,12 @@ bool open_zip_writer(mz_zip_archive *zip, const std::string &fname_utf8);
 bool close_zip_reader(mz_zip_archive *zip);
 bool close_zip_writer(mz_zip_archive *zip);
 
+// Add a memory buffer to an archive as mz_zip_writer_add_mem() does, but compress large buffers
+// in independent chunks in parallel. Each chunk is deflated without the dictionary of the previous chunk
+// and terminated by a sync flush, thus the chunks concatenate into a single valid deflate stream.
+// Level 0 (store only) and small buffers are passed to mz_zip_writer_add_mem() directly.
+bool zip_writer_add_mem_parallel(mz_zip_archive *zip, const char *archive_name, const void *buf, size_t buf_size, mz_uint level_and_flags);
+
 class MZ_Archive {
 public:
     mz_zip_archive arch;
@@ -1,8 +1,13 @@
 #include <catch2/catch_all.hpp>
 
+#include <fstream>
 #include <memory>
+#include <thread>
+
+#include <boost/filesystem.hpp>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCodeReader.hpp"
 
 using namespace Slic3r;
 
@@ -20,3 +25,65 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("Parallel parsing of a G-code file", "[GCode]") {
+	GIVEN("A G-code file spanning multiple chunks, with mixed line ends and without a trailing new line") {
+		boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("gcodereader-%%%%-%%%%.gcode");
+		{
+			std::ofstream out(path.string(), std::ios::binary);
+			out << "; generated by test\nG90\nM83\r\n";
+			for (int i = 0; i < 200000; ++ i)
+				out << "N" << i << " G1 X" << (i % 200) << ".125 Y" << (i % 170) << ".5 E0.0" << (i % 10) << (i % 3 ? "\n" : " ; comment\r\n");
+			out << "\n\nG1 Z10";
+		}
+		auto collect = [](std::vector<std::string> &lines, std::vector<float> &xs) {
+			return [&lines, &xs](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+				lines.emplace_back(line.raw());
+				xs.emplace_back(reader.x());
+			};
+		};
+		std::vector<std::string> lines_serial, lines_parallel;
+		std::vector<float>       xs_serial, xs_parallel;
+		std::vector<size_t>      ends_serial, ends_parallel;
+		GCodeReader reader_serial, reader_parallel;
+		REQUIRE(reader_serial.parse_file(path.string(), collect(lines_serial, xs_serial), ends_serial));
+		const std::thread::id caller = std::this_thread::get_id();
+		bool                  called_off_thread = false;
+		REQUIRE(reader_parallel.parse_file_parallel(path.string(),
+			[&, collect_parallel = collect(lines_parallel, xs_parallel)](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+				called_off_thread |= std::this_thread::get_id() != caller;
+				collect_parallel(reader, line);
+			}, ends_parallel));
+		boost::filesystem::remove(path);
+		THEN("the lines, the reader state and the line ends match the serial parser") {
+			REQUIRE(lines_parallel.size() == lines_serial.size());
+			REQUIRE(lines_parallel == lines_serial);
+			REQUIRE(xs_parallel == xs_serial);
+			REQUIRE(ends_parallel == ends_serial);
+			REQUIRE(reader_parallel.z() == reader_serial.z());
+		}
+		THEN("the callback is called from the calling thread") {
+			REQUIRE(! called_off_thread);
+		}
+	}
+}
+
+SCENARIO("Parsing of axis values", "[GCode]") {
+	GIVEN("A line mixing plain decimals with numbers left to the general parser") {
+		GCodeReader reader;
+		GCodeReader::GCodeLine parsed;
+		reader.parse_line("G1 X12.125 Y-0.5 Z.25 E1e-2 F1234567890123456 ; comment", [&parsed](GCodeReader&, const GCodeReader::GCodeLine &line) { parsed = line; });
+		THEN("all values match strtod") {
+			REQUIRE(parsed.x() == float(12.125));
+			REQUIRE(parsed.y() == float(-0.5));
+			REQUIRE(parsed.z() == float(0.25));
+			REQUIRE(parsed.e() == float(0.01));
+			REQUIRE(parsed.f() == float(1234567890123456.));
+			float value = 0;
+			REQUIRE(parsed.has_value('X', value));
+			REQUIRE(value == float(12.125));
+			REQUIRE(parsed.has_value('E', value));
+			REQUIRE(value == float(0.01));
+		}
+	}
+}
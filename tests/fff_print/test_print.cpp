@@ -4,6 +4,8 @@
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
 
+#include <boost/filesystem.hpp>
+
 #include "test_data.hpp"
 
 using namespace Slic3r;
@@ -138,3 +140,185 @@ SCENARIO("Print: Brim generation", "[Print][.]") {
         }
     }
 }
+
+SCENARIO("Print: Slicing data round trip", "[Print]") {
+    GIVEN("sliced 20mm cube with supports") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.25 },
+            { "first_layer_height", 0.25 },
+            { "enable_support",     true }
+        });
+        Print print;
+        Model model;
+        init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.process();
+        const PrintObject &object = *print.objects().front();
+        std::vector<double> lslices_areas;
+        std::vector<size_t> perimeter_counts;
+        for (const Layer *layer : object.layers()) {
+            lslices_areas.emplace_back(area(layer->lslices));
+            perimeter_counts.emplace_back(layer->regions().front()->perimeters.items_count());
+        }
+        const size_t support_layer_count = object.support_layer_count();
+        boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        for (bool binary : { true, false }) {
+            WHEN(binary ? "Exported and loaded in the binary format" : "Exported and loaded in the JSON format") {
+                REQUIRE(print.export_cached_data(dir.string(), false, binary) == 0);
+                REQUIRE(print.load_cached_data(dir.string()) == 0);
+                THEN("The layers are restored") {
+                    REQUIRE(object.layer_count() == lslices_areas.size());
+                    REQUIRE(object.support_layer_count() == support_layer_count);
+                    for (size_t i = 0; i < object.layer_count(); ++ i) {
+                        const Layer *layer = object.get_layer(int(i));
+                        REQUIRE(area(layer->lslices) == Catch::Approx(lslices_areas[i]));
+                        REQUIRE(layer->regions().front()->perimeters.items_count() == perimeter_counts[i]);
+                        if (i > 0)
+                            REQUIRE(layer->lower_layer == object.get_layer(int(i) - 1));
+                    }
+                }
+            }
+        }
+        boost::filesystem::remove_all(dir);
+    }
+}
+
+SCENARIO("Print: Process profiler", "[Print]") {
+    GIVEN("20mm cube and an enabled profiler") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        Print print;
+        Model model;
+        init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.profiler().set_enabled(true);
+        WHEN("The print is processed") {
+            print.process();
+            std::vector<ProcessProfiler::Stage> stages = print.profiler().stages();
+            auto find_stage = [&stages](const std::string &name) {
+                return std::find_if(stages.begin(), stages.end(), [&name](const ProcessProfiler::Stage &stage) { return stage.name == name; });
+            };
+            THEN("The object stages are recorded with their layers") {
+                for (const char *name : { "slice", "perimeters", "prepare_infill", "infill" })
+                    REQUIRE(find_stage(name) != stages.end());
+                auto perimeters = find_stage("perimeters");
+                REQUIRE(perimeters->num_layers == print.objects().front()->layer_count());
+                size_t num_binned = 0;
+                for (size_t count : perimeters->layer_histogram)
+                    num_binned += count;
+                REQUIRE(num_binned == perimeters->num_layers);
+            }
+            THEN("The whole process is recorded and covers the object stages") {
+                auto process = find_stage("process");
+                REQUIRE(process != stages.end());
+                REQUIRE(process->wall_time >= find_stage("perimeters")->wall_time);
+            }
+        }
+        WHEN("The profiler is disabled") {
+            print.profiler().set_enabled(false);
+            print.process();
+            THEN("Nothing is recorded") {
+                REQUIRE(print.profiler().stages().empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Re-slicing after a layer range edit", "[Print]") {
+    GIVEN("sliced 20mm cube") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.2 },
+            { "first_layer_height", 0.2 }
+        });
+        Print print;
+        Model model;
+        init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.process();
+        WHEN("The layer height of the top 5mm is changed") {
+            model.objects.front()->layer_config_ranges[{ 15., 20. }].set_key_value("layer_height", new ConfigOptionFloat(0.1));
+            print.apply(model, config);
+            print.profiler().set_enabled(true);
+            print.process();
+            Print print_fresh;
+            print_fresh.apply(model, config);
+            print_fresh.set_status_silent();
+            print_fresh.process();
+            const PrintObject &object       = *print.objects().front();
+            const PrintObject &object_fresh = *print_fresh.objects().front();
+            THEN("The layers match the layers of a print sliced from scratch") {
+                REQUIRE(object.layer_count() == object_fresh.layer_count());
+                for (size_t i = 0; i < object.layer_count(); ++ i) {
+                    const Layer *layer       = object.get_layer(int(i));
+                    const Layer *layer_fresh = object_fresh.get_layer(int(i));
+                    REQUIRE(layer->print_z == layer_fresh->print_z);
+                    REQUIRE(layer->lslices == layer_fresh->lslices);
+                    REQUIRE(layer->regions().front()->perimeters.items_count() == layer_fresh->regions().front()->perimeters.items_count());
+                    REQUIRE(layer->regions().front()->fill_expolygons == layer_fresh->regions().front()->fill_expolygons);
+                }
+            }
+            THEN("Only the walls of the layers around the edited range are generated again") {
+                std::vector<ProcessProfiler::Stage> stages = print.profiler().stages();
+                auto perimeters = std::find_if(stages.begin(), stages.end(), [](const ProcessProfiler::Stage &stage) { return stage.name == "perimeters"; });
+                REQUIRE(perimeters != stages.end());
+                REQUIRE(perimeters->num_layers > 0);
+                REQUIRE(perimeters->num_layers < object.layer_count() / 2);
+            }
+        }
+        WHEN("The print does not retain the volume slices") {
+            REQUIRE(! print.objects().front()->volume_slice_cache().empty());
+            print.set_retain_volume_slices(false);
+            model.objects.front()->layer_config_ranges[{ 15., 20. }].set_key_value("layer_height", new ConfigOptionFloat(0.1));
+            print.apply(model, config);
+            print.process();
+            THEN("The slices of the volumes are released after slicing") {
+                REQUIRE(print.objects().front()->volume_slice_cache().empty());
+                REQUIRE(print.objects().front()->layer_count() > 0);
+            }
+            THEN("The per volume slices used to group the volumes for the brim are released as well") {
+                REQUIRE(print.objects().front()->firstLayerObjSlice().empty());
+                REQUIRE(! print.objects().front()->firstLayerObjGroups().empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Slicing of a copy rotated around the Z axis", "[Print]") {
+    GIVEN("An object with two instances, the second one rotated by 30 degrees around the Z axis") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        Print print;
+        Model model;
+        init_print({TestMesh::overhang}, print, model, config);
+        ModelObject   *model_object = model.objects.front();
+        ModelInstance *rotated      = model_object->add_instance(*model_object->instances.front());
+        rotated->set_rotation(Z, PI / 6.);
+        rotated->set_offset(X, rotated->get_offset(X) + 50.);
+        print.apply(model, config);
+        print.process();
+        WHEN("The rotated instance is sliced alone") {
+            Model model_rotated(model);
+            model_rotated.objects.front()->delete_instance(0);
+            Print print_rotated;
+            print_rotated.apply(model_rotated, config);
+            print_rotated.set_status_silent();
+            print_rotated.process();
+            const PrintObject &object_fresh = *print_rotated.objects().front();
+            THEN("The layers of the rotated copy match the layers sliced from scratch") {
+                REQUIRE(print.objects().size() == 2);
+                auto it_object = std::find_if(print.objects().begin(), print.objects().end(),
+                    [&object_fresh](const PrintObject *object) { return object->trafo().isApprox(object_fresh.trafo()); });
+                REQUIRE(it_object != print.objects().end());
+                const PrintObject &object = **it_object;
+                // The slices of the rotated copy were transformed from the first instance, not sliced again.
+                REQUIRE(object.slices_from_donor());
+                REQUIRE(! object_fresh.slices_from_donor());
+                REQUIRE(object.layer_count() == object_fresh.layer_count());
+                for (size_t i = 0; i < object.layer_count(); ++ i) {
+                    const Layer *layer       = object.get_layer(int(i));
+                    const Layer *layer_fresh = object_fresh.get_layer(int(i));
+                    REQUIRE(layer->print_z == layer_fresh->print_z);
+                    REQUIRE(layer->lslices.size() == layer_fresh->lslices.size());
+                    REQUIRE(area(layer->lslices) == Catch::Approx(area(layer_fresh->lslices)).epsilon(1e-4));
+                }
+            }
+        }
+    }
+}
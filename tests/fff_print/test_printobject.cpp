@@ -4,6 +4,8 @@
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
 
+#include <boost/filesystem.hpp>
+
 #include "test_data.hpp"
 
 using namespace Slic3r;
@@ -87,3 +89,58 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject][.]") {
 #endif
     }
 }
+
+SCENARIO("PrintObject: persistent step cache", "[PrintObject]") {
+    GIVEN("20mm cube and an empty step cache directory") {
+        boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::create_directories(cache_dir);
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.25 },
+            { "first_layer_height", 0.25 }
+        });
+        auto process = [&cache_dir, &config](Print &print, Model &model) {
+            init_print({TestMesh::cube_20x20x20}, print, model, config);
+            print.set_step_cache_dir(cache_dir.string());
+            print.process();
+        };
+        auto num_cache_files = [&cache_dir]() {
+            size_t cnt = 0;
+            for (const boost::filesystem::directory_entry &entry : boost::filesystem::directory_iterator(cache_dir))
+                if (boost::filesystem::is_regular_file(entry.status()) && entry.path().extension() == ".json")
+                    ++ cnt;
+            return cnt;
+        };
+        Print print1;
+        Model model1;
+        process(print1, model1);
+        THEN("Results of slicing, perimeters and infill preparation are stored") {
+            REQUIRE(num_cache_files() == 3);
+        }
+        WHEN("The same object is processed again") {
+            Print print2;
+            Model model2;
+            process(print2, model2);
+            THEN("No new cache entries are created and the restored layers match") {
+                REQUIRE(num_cache_files() == 3);
+                const PrintObject &object1 = *print1.objects().front();
+                const PrintObject &object2 = *print2.objects().front();
+                REQUIRE(object1.layer_count() == object2.layer_count());
+                for (size_t i = 0; i < object1.layer_count(); ++ i) {
+                    REQUIRE(object1.get_layer(int(i))->print_z == Catch::Approx(object2.get_layer(int(i))->print_z));
+                    REQUIRE(area(object1.get_layer(int(i))->lslices) == Catch::Approx(area(object2.get_layer(int(i))->lslices)));
+                }
+            }
+        }
+        WHEN("Only the number of walls changes") {
+            config.set_deserialize_strict({ { "wall_loops", 4 } });
+            Print print2;
+            Model model2;
+            process(print2, model2);
+            THEN("Slicing is reused, walls and infill preparation are cached anew") {
+                REQUIRE(num_cache_files() == 5);
+            }
+        }
+        boost::filesystem::remove_all(cache_dir);
+    }
+}
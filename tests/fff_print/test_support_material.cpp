@@ -8,6 +8,47 @@
 using namespace Slic3r::Test;
 using namespace Slic3r;
 
+SCENARIO("SupportMaterial: Organic tree supports within an avoidance memory budget", "[SupportMaterial]")
+{
+    GIVEN("an object with overhangs supported by organic tree supports") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({
+            { "layer_height",       0.3 },
+            { "first_layer_height", 0.3 },
+            { "enable_support",     true },
+            { "support_type",       "tree(auto)" },
+            { "support_style",      "organic" }
+        });
+        auto process = [&config](Print &print, Model &model, size_t budget) {
+            init_print({TestMesh::ipadstand}, print, model, config);
+            print.set_tree_support_avoidance_memory_budget(budget);
+            print.process();
+        };
+        Print print, print_budget;
+        Model model, model_budget;
+        process(print, model, 0);
+        // Small enough for all but the checkpoint layers to be dropped and recalculated by the pathing.
+        process(print_budget, model_budget, 1);
+        const PrintObject &object        = *print.objects().front();
+        const PrintObject &object_budget = *print_budget.objects().front();
+        REQUIRE(object.support_layer_count() > 0);
+        THEN("the supports match the supports generated without a budget") {
+            REQUIRE(object_budget.support_layer_count() == object.support_layer_count());
+            for (size_t i = 0; i < object.support_layer_count(); ++ i) {
+                const SupportLayer *layer        = object.support_layers()[i];
+                const SupportLayer *layer_budget = object_budget.support_layers()[i];
+                REQUIRE(layer_budget->print_z == layer->print_z);
+                REQUIRE(layer_budget->support_islands == layer->support_islands);
+                REQUIRE(layer_budget->support_fills.items_count() == layer->support_fills.items_count());
+            }
+        }
+        THEN("the avoidance caches hold less memory at their peak") {
+            REQUIRE(object.tree_support_avoidance_memory_peak() > 0);
+            REQUIRE(object_budget.tree_support_avoidance_memory_peak() < object.tree_support_avoidance_memory_peak());
+        }
+    }
+}
+
 TEST_CASE("SupportMaterial: Three raft layers created", "[SupportMaterial][.]")
 {
 	Slic3r::Print print;
@@ -2,6 +2,7 @@
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/miniz_extension.hpp"
 
 #include <boost/filesystem/operations.hpp>
 
@@ -193,3 +194,36 @@ SCENARIO("2D convex hull of sinking object", "[3mf][.]") {
         }
     }
 }
+
+SCENARIO("Zip entries deflated in parallel chunks", "[3mf]") {
+    GIVEN("G-code spanning multiple compression chunks") {
+        std::string gcode;
+        for (int i = 0; gcode.size() < 5 * 1024 * 1024 + 17; ++ i)
+            gcode += "G1 X" + std::to_string(i % 2000) + " Y" + std::to_string((i * 7) % 1500) + " E" + std::to_string(i) + "\n";
+
+        for (int level : { -1, 0, 1, 9 }) {
+            WHEN("the G-code is added to an archive at level " + std::to_string(level)) {
+                mz_zip_archive archive;
+                mz_zip_zero_struct(&archive);
+                REQUIRE(mz_zip_writer_init_heap(&archive, 0, 0));
+                REQUIRE(zip_writer_add_mem_parallel(&archive, "plate_1.gcode", gcode.data(), gcode.size(), mz_uint(level)));
+                void  *zip_data = nullptr;
+                size_t zip_size = 0;
+                REQUIRE(mz_zip_writer_finalize_heap_archive(&archive, &zip_data, &zip_size));
+                mz_zip_writer_end(&archive);
+
+                THEN("the extracted entry matches the G-code") {
+                    mz_zip_zero_struct(&archive);
+                    REQUIRE(mz_zip_reader_init_mem(&archive, zip_data, zip_size, 0));
+                    size_t extracted_size = 0;
+                    void  *extracted = mz_zip_reader_extract_file_to_heap(&archive, "plate_1.gcode", &extracted_size, 0);
+                    REQUIRE(extracted != nullptr);
+                    CHECK(std::string(static_cast<const char*>(extracted), extracted_size) == gcode);
+                    mz_free(extracted);
+                    mz_zip_reader_end(&archive);
+                }
+                mz_free(zip_data);
+            }
+        }
+    }
+}
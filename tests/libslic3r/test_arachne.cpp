@@ -0,0 +1,97 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/Arachne/WallToolPaths.hpp"
+#include "libslic3r/Arachne/SkeletalTrapezoidationGraph.hpp"
+#include "libslic3r/ClipperUtils.hpp"
+
+using namespace Slic3r;
+
+TEST_CASE("WallToolPathsCache reuses toolpaths of translated outlines", "[ArachneCache]") {
+    // An L shaped outline with a narrow leg, which produces walls of variable width.
+    Polygon outline { { 0, 0 }, { scaled<coord_t>(20.), 0 }, { scaled<coord_t>(20.), scaled<coord_t>(1.1) }, { scaled<coord_t>(1.3), scaled<coord_t>(1.1) },
+                      { scaled<coord_t>(1.3), scaled<coord_t>(15.) }, { 0, scaled<coord_t>(15.) } };
+    Polygon shifted = outline;
+    shifted.translate(scaled<coord_t>(37.5), scaled<coord_t>(-12.25));
+
+    const coord_t                      bead_width = scaled<coord_t>(0.4);
+    const Arachne::WallToolPathsParams params { 0.3f, 0.1f, 0.5f, 0.4f, 10.f, 0.025f, 1, false };
+
+    auto generate = [&](Arachne::WallToolPathsCache &cache, const Polygon &polygon, std::vector<Arachne::VariableWidthLines> &toolpaths, Polygons &inner_contour) {
+        cache.generate({ polygon }, bead_width, bead_width, 3, 0, 0.2, params, toolpaths, inner_contour);
+    };
+
+    Arachne::WallToolPathsCache              cache;
+    std::vector<Arachne::VariableWidthLines> toolpaths, toolpaths_shifted, toolpaths_fresh;
+    Polygons                                 inner_contour, inner_contour_shifted, inner_contour_fresh;
+    generate(cache, outline, toolpaths, inner_contour);
+    generate(cache, shifted, toolpaths_shifted, inner_contour_shifted);
+    {
+        // Reference generated without the cache for the translated outline moved to the origin of its bounding box,
+        // which is what the cache does, then moved back.
+        const Point normalize = get_extents(shifted).min;
+        Polygon     normalized = shifted;
+        normalized.translate(- normalize);
+        Arachne::WallToolPaths wall_tool_paths({ normalized }, bead_width, bead_width, 3, 0, 0.2, params);
+        toolpaths_fresh     = wall_tool_paths.getToolPaths();
+        inner_contour_fresh = wall_tool_paths.getInnerContour();
+        for (Arachne::VariableWidthLines &lines : toolpaths_fresh)
+            for (Arachne::ExtrusionLine &line : lines)
+                for (Arachne::ExtrusionJunction &junction : line.junctions)
+                    junction.p += normalize;
+        for (Polygon &polygon : inner_contour_fresh)
+            polygon.translate(normalize);
+    }
+
+    REQUIRE(! toolpaths.empty());
+    THEN("Toolpaths taken from the cache match uncached toolpaths of the translated outline moved to the origin") {
+        REQUIRE(toolpaths_shifted.size() == toolpaths_fresh.size());
+        for (size_t i = 0; i < toolpaths_fresh.size(); ++ i) {
+            REQUIRE(toolpaths_shifted[i].size() == toolpaths_fresh[i].size());
+            for (size_t j = 0; j < toolpaths_fresh[i].size(); ++ j) {
+                const Arachne::ExtrusionLine &l1 = toolpaths_shifted[i][j];
+                const Arachne::ExtrusionLine &l2 = toolpaths_fresh[i][j];
+                REQUIRE(l1.inset_idx == l2.inset_idx);
+                REQUIRE(l1.is_closed == l2.is_closed);
+                REQUIRE(l1.junctions.size() == l2.junctions.size());
+                for (size_t k = 0; k < l1.junctions.size(); ++ k) {
+                    REQUIRE(l1.junctions[k].p == l2.junctions[k].p);
+                    REQUIRE(l1.junctions[k].w == l2.junctions[k].w);
+                }
+            }
+        }
+        REQUIRE(inner_contour_shifted == inner_contour_fresh);
+    }
+    THEN("Toolpaths taken from the cache match toolpaths generated in place for the translated outline") {
+        Arachne::WallToolPaths wall_tool_paths({ shifted }, bead_width, bead_width, 3, 0, 0.2, params);
+        const Polygons        &inner_contour_in_place = wall_tool_paths.getInnerContour();
+        REQUIRE(wall_tool_paths.getToolPaths().size() == toolpaths_shifted.size());
+        REQUIRE(std::abs(area(inner_contour_in_place) - area(inner_contour_shifted)) < 0.01 * std::abs(area(inner_contour_in_place)));
+        REQUIRE(get_extents(inner_contour_in_place).min.cast<double>().isApprox(get_extents(inner_contour_shifted).min.cast<double>(), 1e-3));
+    }
+    THEN("The cached toolpaths are translated") {
+        REQUIRE(std::abs(area(inner_contour_shifted) - area(inner_contour)) < EPSILON);
+        REQUIRE(get_extents(inner_contour_shifted).min == get_extents(inner_contour).min + Point(scaled<coord_t>(37.5), scaled<coord_t>(-12.25)));
+    }
+}
+
+TEST_CASE("SkeletalTrapezoidationGraph recycles the memory of removed elements", "[ArachneGraph]") {
+    Arachne::SkeletalTrapezoidationGraph graph;
+    graph.nodes.emplace_back(Arachne::SkeletalTrapezoidationJoint(), Point(0, 0));
+    graph.nodes.emplace_back(Arachne::SkeletalTrapezoidationJoint(), Point(10, 0));
+    graph.edges.emplace_back(Arachne::SkeletalTrapezoidationEdge());
+    const Arachne::STHalfEdgeNode *removed = &graph.nodes.back();
+    graph.nodes.pop_back();
+    graph.nodes.emplace_back(Arachne::SkeletalTrapezoidationJoint(), Point(20, 0));
+    REQUIRE(&graph.nodes.back() == removed);
+    REQUIRE(graph.nodes.back().p == Point(20, 0));
+
+    // Moving the graph keeps the addresses of its elements, the half-edge links stay valid.
+    const Arachne::STHalfEdge *edge = &graph.edges.front();
+    Arachne::SkeletalTrapezoidationGraph moved = std::move(graph);
+    REQUIRE(&moved.edges.front() == edge);
+    REQUIRE(moved.nodes.size() == 2);
+
+    // The moved-from graph keeps its arena and stays usable.
+    graph.nodes.emplace_back(Arachne::SkeletalTrapezoidationJoint(), Point(30, 0));
+    REQUIRE(graph.nodes.size() == 1);
+}
@@ -103,6 +103,41 @@ TEST_CASE("Split two watertight meshes", "[its_split][its]") {
     debug_write_obj(res, "parts_watertight");
 }
 
+TEST_CASE("Split many parts", "[its_split][its]") {
+    using namespace Slic3r;
+
+    const size_t         num_cubes = 100;
+    indexed_triangle_set cube      = its_make_cube(1., 1., 1.);
+    indexed_triangle_set cubes;
+    for (size_t i = 0; i < num_cubes; ++ i) {
+        indexed_triangle_set its = cube;
+        its_transform(its, identity3f().translate(Vec3f{ 2.f * float(i), 0.f, 0.f }));
+        its_merge(cubes, its);
+    }
+    // Add duplicate and unreferenced vertices to be cleaned up.
+    indexed_triangle_set unreferenced = cube;
+    its_transform(unreferenced, identity3f().translate(Vec3f{ -10.f, 0.f, 0.f }));
+    its_merge(cubes, unreferenced);
+    cubes.indices.resize(cubes.indices.size() - cube.indices.size());
+    cubes.vertices.emplace_back(cubes.vertices.front());
+    cubes.indices.front()(0) = int(cubes.vertices.size()) - 1;
+
+    REQUIRE(its_merge_vertices(cubes) == 1);
+    REQUIRE(its_compactify_vertices(cubes) == int(cube.vertices.size()));
+    REQUIRE(its_remove_degenerate_faces(cubes) == 0);
+    REQUIRE(its_number_of_patches(cubes) == num_cubes);
+
+    std::vector<indexed_triangle_set> res = its_split(cubes);
+
+    REQUIRE(res.size() == num_cubes);
+    for (size_t i = 0; i < num_cubes; ++ i) {
+        REQUIRE(res[i].indices.size() == cube.indices.size());
+        REQUIRE(res[i].vertices.size() == cube.vertices.size());
+        // The parts are ordered by their lowest face index.
+        REQUIRE(bounding_box(res[i]).min.x() == Catch::Approx(2. * double(i)));
+    }
+}
+
 #include <libslic3r/QuadricEdgeCollapse.hpp>
 static float triangle_area(const Vec3f &v0, const Vec3f &v1, const Vec3f &v2)
 {
@@ -0,0 +1,46 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/Model.hpp"
+#include "libslic3r/Format/OBJ.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+using namespace Slic3r;
+
+SCENARIO("Reading an OBJ file", "[obj]") {
+	GIVEN("a cube with vertex colors, quads and relative vertex indices") {
+		std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("obj-%%%%-%%%%.obj")).string();
+		{
+			boost::nowide::ofstream out(path);
+			out << "# cube\r\n"
+				<< "v 0 0 0 1 0 0\r\n"  << "v 10 0 0 0 1 0\r\n"  << "v 10 10 0 0 0 1\r\n"  << "v 0 10 0 2 0 0 0.5\r\n"
+				<< "v 0 0 10\r\n"       << "v 10 0 10\r\n"       << "v 10 10 10\r\n"       << "v 0 10 10\r\n"
+				<< "vn 0 0 1\r\n"
+				<< "f 1//1 4//1 3//1 2//1\r\n" << "f 5 6 7 8\r\n"
+				<< "f 1 2 6 5\r\n" << "f 2 3 7 6\r\n" << "f 3 4 8 7\r\n"
+				<< "f -5 -8 -4\r\n" << "f -5 -4 -1\n";
+		}
+		WHEN("OBJ file is read") {
+			TriangleMesh mesh;
+			ObjInfo      obj_info;
+			std::string  message;
+			THEN("the quads are triangulated and the relative indices resolved") {
+				REQUIRE(load_obj(path.c_str(), &mesh, obj_info, message));
+				REQUIRE(mesh.its.vertices.size() == 8);
+				REQUIRE(mesh.its.indices.size() == 12);
+				REQUIRE(its_num_open_edges(mesh.its) == 0);
+				REQUIRE(mesh.volume() == Catch::Approx(1000.));
+			}
+			THEN("the vertex colors are clamped and the vertices without a color are undefined") {
+				REQUIRE(load_obj(path.c_str(), &mesh, obj_info, message));
+				REQUIRE(obj_info.vertex_colors.size() == 8);
+				REQUIRE(obj_info.vertex_colors[0] == RGBA{ 1.f, 0.f, 0.f, 1.f });
+				REQUIRE(obj_info.vertex_colors[3] == RGBA{ 1.f, 0.f, 0.f, 0.5f });
+				REQUIRE(obj_info.vertex_colors[4] == UNDEFINE_COLOR);
+			}
+		}
+		boost::filesystem::remove(path);
+	}
+}
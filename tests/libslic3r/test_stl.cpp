@@ -2,6 +2,9 @@
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+#include <boost/filesystem.hpp>
 
 using namespace Slic3r;
 
@@ -55,3 +58,32 @@ SCENARIO("Reading an STL file", "[stl]") {
 		}
 	}
 }
+
+SCENARIO("Reading a binary STL file without admesh", "[stl]") {
+	GIVEN("a closed cube stored as a binary STL") {
+		indexed_triangle_set cube = its_make_cube(20., 20., 20.);
+		std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("stl-%%%%-%%%%.stl")).string();
+		REQUIRE(its_write_stl_binary(path.c_str(), "", cube));
+		WHEN("STL file is read") {
+			indexed_triangle_set its;
+			THEN("the vertices are welded") {
+				REQUIRE(its_read_stl_binary_manifold(path.c_str(), its) == StlReadResult::Loaded);
+				REQUIRE(its.vertices.size() == cube.vertices.size());
+				REQUIRE(its.indices.size() == cube.indices.size());
+				REQUIRE(its_num_open_edges(its) == 0);
+			}
+		}
+		WHEN("a face is missing") {
+			cube.indices.pop_back();
+			REQUIRE(its_write_stl_binary(path.c_str(), "", cube));
+			indexed_triangle_set its;
+			THEN("the mesh is left to admesh to be repaired") {
+				REQUIRE(its_read_stl_binary_manifold(path.c_str(), its) == StlReadResult::Fallback);
+				Slic3r::Model model;
+				REQUIRE(Slic3r::load_stl(path.c_str(), &model));
+				REQUIRE(is_approx(model.objects.front()->volumes.front()->mesh().size(), Vec3d(20, 20, 20)));
+			}
+		}
+		boost::filesystem::remove(path);
+	}
+}
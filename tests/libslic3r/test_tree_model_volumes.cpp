@@ -0,0 +1,125 @@
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "libslic3r/Support/TreeModelVolumes.hpp"
+
+using namespace Slic3r;
+using namespace Slic3r::TreeSupport3D;
+
+using RadiusLayerPolygonCache = TreeModelVolumes::RadiusLayerPolygonCache;
+
+// A square identifying the radius and the layer it was inserted for.
+static Polygons key_area(coord_t radius, LayerIndex layer_idx)
+{
+    const coord_t size = 1000 * (layer_idx + 1) + radius;
+    return { Polygon { { 0, 0 }, { size, 0 }, { size, size }, { 0, size } } };
+}
+
+static void insert(RadiusLayerPolygonCache &cache, coord_t radius, LayerIndex layer_idx, Polygons &&polygons)
+{
+    std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, Polygons>> in;
+    in.emplace_back(TreeModelVolumes::RadiusLayerPair(radius, layer_idx), std::move(polygons));
+    cache.insert(std::move(in));
+}
+
+TEST_CASE("RadiusLayerPolygonCache inserts and looks up areas from multiple threads", "[TreeSupport]") {
+    // Spanning multiple segments of layers, with more radii per layer than the initial capacity of the entries.
+    static constexpr const LayerIndex num_layers = 300;
+    static constexpr const coord_t    num_radii  = 10;
+    RadiusLayerPolygonCache cache;
+    std::atomic<bool>       mismatch { false };
+    // Consecutive tasks insert into different layers, thus the radii of a single layer are inserted by different threads.
+    tbb::parallel_for(tbb::blocked_range<int>(0, num_layers * num_radii, 1), [&cache, &mismatch](const tbb::blocked_range<int> &range) {
+        for (int i = range.begin(); i < range.end(); ++ i) {
+            const LayerIndex layer_idx = i % num_layers;
+            const coord_t    radius    = 1 + i / num_layers;
+            insert(cache, radius, layer_idx, key_area(radius, layer_idx));
+            auto area = cache.getArea({ radius, layer_idx });
+            if (! area || area->get() != key_area(radius, layer_idx))
+                mismatch = true;
+            // The areas inserted by the other threads are either missing or complete.
+            for (coord_t other_radius = 1; other_radius <= num_radii; ++ other_radius)
+                if (auto other = cache.getArea({ other_radius, layer_idx }); other && other->get() != key_area(other_radius, layer_idx))
+                    mismatch = true;
+        }
+    });
+    REQUIRE(! mismatch);
+    THEN("All the areas are found") {
+        for (LayerIndex layer_idx = 0; layer_idx < num_layers; ++ layer_idx)
+            for (coord_t radius = 1; radius <= num_radii; ++ radius) {
+                auto area = cache.getArea({ radius, layer_idx });
+                REQUIRE(area);
+                REQUIRE(area->get() == key_area(radius, layer_idx));
+            }
+        REQUIRE(cache.sorted().size() == size_t(num_layers * num_radii));
+        REQUIRE(cache.getMaxCalculatedLayer(1) == num_layers - 1);
+        REQUIRE(cache.memory_used() > 0);
+    }
+}
+
+TEST_CASE("RadiusLayerPolygonCache keeps the area inserted first", "[TreeSupport]") {
+    RadiusLayerPolygonCache cache;
+    insert(cache, 5, 3, key_area(5, 3));
+    const size_t memory_used = cache.memory_used();
+    insert(cache, 5, 3, key_area(7, 3));
+    auto area = cache.getArea({ 5, 3 });
+    REQUIRE(area);
+    REQUIRE(area->get() == key_area(5, 3));
+    REQUIRE(cache.memory_used() == memory_used);
+}
+
+TEST_CASE("RadiusLayerPolygonCache releases layers", "[TreeSupport]") {
+    RadiusLayerPolygonCache cache;
+    for (LayerIndex layer_idx = 0; layer_idx < 100; ++ layer_idx)
+        for (coord_t radius : { 3, 1 })
+            insert(cache, radius, layer_idx, key_area(radius, layer_idx));
+    const size_t memory_used = cache.memory_used();
+
+    WHEN("The layers from 40 up are released") {
+        cache.clear_layers_from(40);
+        THEN("Only the layers below are found") {
+            REQUIRE(cache.getMaxCalculatedLayer(1) == 39);
+            REQUIRE(cache.getMaxCalculatedLayer(3, 20) == 20);
+            REQUIRE(! cache.getArea({ 1, 40 }));
+            REQUIRE(! cache.getArea({ 3, 99 }));
+            REQUIRE(cache.memory_used() < memory_used);
+        }
+        THEN("The lower bound areas are looked up below the released layers only") {
+            auto lower_bound = cache.get_lower_bound_area({ 2, 20 });
+            REQUIRE(lower_bound);
+            REQUIRE(lower_bound->first == 1);
+            REQUIRE(lower_bound->second.get() == key_area(1, 20));
+            lower_bound = cache.get_lower_bound_area({ 10, 39 });
+            REQUIRE(lower_bound);
+            REQUIRE(lower_bound->first == 3);
+            REQUIRE(! cache.get_lower_bound_area({ 0, 20 }));
+            REQUIRE(! cache.get_lower_bound_area({ 10, 50 }));
+        }
+        THEN("The released layers may be calculated again") {
+            insert(cache, 1, 60, key_area(1, 60));
+            REQUIRE(cache.getMaxCalculatedLayer(1) == 60);
+            REQUIRE(cache.getMaxCalculatedLayer(1, 59) == 39);
+            REQUIRE(cache.getArea({ 1, 60 })->get() == key_area(1, 60));
+        }
+    }
+    WHEN("All but the smallest radius are released") {
+        for (LayerIndex layer_idx = 0; layer_idx < 100; ++ layer_idx)
+            insert(cache, 2, layer_idx, key_area(2, layer_idx));
+        cache.clear_all_but_radius0();
+        THEN("The areas of the smallest radius are kept") {
+            for (LayerIndex layer_idx = 0; layer_idx < 100; ++ layer_idx) {
+                auto area = cache.getArea({ 1, layer_idx });
+                REQUIRE(area);
+                REQUIRE(area->get() == key_area(1, layer_idx));
+                REQUIRE(! cache.getArea({ 2, layer_idx }));
+                REQUIRE(! cache.getArea({ 3, layer_idx }));
+                REQUIRE(cache.get_lower_bound_area({ 5, layer_idx })->first == 1);
+            }
+            REQUIRE(cache.memory_used() < memory_used);
+        }
+    }
+}
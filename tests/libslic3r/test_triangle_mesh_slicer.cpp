@@ -0,0 +1,50 @@
+#include <catch2/catch_all.hpp>
+
+#include "libslic3r/ClipperUtils.hpp"
+#include "libslic3r/Geometry.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/TriangleMeshSlicer.hpp"
+
+using namespace Slic3r;
+
+// Slicing planes at the given layer height, with a few planes passing exactly through the vertices of the mesh.
+static std::vector<float> slicing_zs(const indexed_triangle_set &its, float layer_height)
+{
+    BoundingBoxf3      bbox = bounding_box(its);
+    std::vector<float> zs;
+    for (float z = float(bbox.min.z()) + 0.5f * layer_height; z < float(bbox.max.z()); z += layer_height)
+        zs.emplace_back(z);
+    for (size_t i = 0; i < its.vertices.size(); i += its.vertices.size() / 7 + 1)
+        zs.emplace_back(its.vertices[i].z());
+    sort_remove_duplicates(zs);
+    return zs;
+}
+
+TEST_CASE("Slicing at multiple planes matches slicing at each plane separately", "[TriangleMeshSlicer]") {
+    indexed_triangle_set its = its_make_sphere(25., 2. * PI / 90.);
+    its_merge(its, its_make_cube(10., 20., 30.));
+    std::vector<float> zs = slicing_zs(its, 0.3f);
+
+    auto trafo = GENERATE(
+        Transform3d(Transform3d::Identity()),
+        Transform3d(Geometry::assemble_transform(Vec3d(3., -7., 1.), Vec3d(0.3, -0.2, 1.1), Vec3d(1.5, 1., 0.8))));
+    MeshSlicingParams params;
+    params.trafo = trafo;
+
+    std::vector<Polygons> layers = slice_mesh(its, zs, params);
+    REQUIRE(layers.size() == zs.size());
+    for (size_t i = 0; i < zs.size(); ++ i) {
+        Polygons layer = slice_mesh(its, zs[i], params);
+        REQUIRE(area(union_ex(layers[i])) == Catch::Approx(area(union_ex(layer))));
+    }
+}
+
+TEST_CASE("Benchmark slicing a high resolution mesh at fine layers", "[TriangleMeshSlicer][.][benchmark]") {
+    indexed_triangle_set its = its_make_sphere(50., 2. * PI / 720.);
+    std::vector<float>   zs   = slicing_zs(its, 0.05f);
+    MeshSlicingParamsEx  params;
+    params.trafo = Geometry::assemble_transform(Vec3d::Zero(), Vec3d(0., 0., 0.5));
+    INFO("triangles: " << its.indices.size() << ", layers: " << zs.size());
+
+    BENCHMARK("slice_mesh_ex") { return slice_mesh_ex(its, zs, params); };
+}